@@ -0,0 +1,343 @@
+// TODO replace this with platform-agnostic version at
+// http://nadeausoftware.com/articles/2012/04/c_c_tip_how_measure_elapsed_real_time_benchmarking
+// or similar
+#include <sys/time.h>
+
+// Need malloc and rand
+#include <cstdlib>
+// Need for ostream
+#include <iostream>
+#include <list>
+
+// This is what I'm using to compare to
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// This is my test file
+#include "sl-merge.hpp"
+
+// Total number of elements across all of the runs being merged
+constexpr size_t MAX_VECTOR_SIZE = 100000000;
+constexpr size_t MIN_RUNS = 2;
+constexpr size_t MAX_RUNS = 256;
+// Elements in the stability check, with keys drawn from N_KEYS values so
+// that every run holds many duplicates
+constexpr size_t KEYED_VECTOR_SIZE = 1000000;
+constexpr int N_KEYS = 100;
+static int random_numbers[MAX_VECTOR_SIZE];
+static struct timeval start_time;
+
+/*
+ * Convenience function for setting the current time
+ */
+static void init_start_time(void)
+{
+    gettimeofday(&start_time, NULL);
+}
+
+/*
+ * Convenience function for getting the time since the last call to
+ * init_start_time
+ */
+static double get_time(void)
+{
+    struct timeval end_time;
+    gettimeofday(&end_time, NULL);
+    double diff = (double)(end_time.tv_sec - start_time.tv_sec)
+                + (double)(end_time.tv_usec - start_time.tv_usec) / 1e6;
+
+    return diff;
+}
+
+/*
+ * Initialize the random numbers used in the rest of the testing
+ */
+static void initialize_random_numbers(void)
+{
+    for (size_t i = 0; i < MAX_VECTOR_SIZE; i++)
+    {
+        random_numbers[i] = (int)rand();
+    }
+}
+
+struct TimeResult
+{
+    public:
+        std::string tag;
+        double time;
+        TimeResult(std::string tag, double time)
+        {
+            this->tag = tag;
+            this->time = time;
+        }
+};
+
+class ResultList : public std::list<TimeResult>
+{
+};
+
+std::ostream& operator<< (std::ostream & o, ResultList r)
+{
+    for (auto tr : r)
+    {
+        o << tr.tag << ": " << tr.time << std::endl;
+    }
+    return o;
+}
+
+/*
+ * Report whether a merge produced the same output as sorting everything
+ */
+static void check_merge(const std::vector<int> & expected,
+        const std::vector<int> & out, const std::string & tag)
+{
+    if (expected != out)
+    {
+        std::cout << "ERROR: " << tag << " output is not sorted" << std::endl;
+    }
+}
+
+/*
+ * An element which only compares by key, and remembers which run it came
+ * from and where, so a stable merge can be told apart from an unstable one
+ */
+struct Keyed
+{
+    int key;
+    size_t run;
+    size_t index;
+
+    bool operator==(const Keyed & other) const
+    {
+        return key == other.key && run == other.run && index == other.index;
+    }
+};
+
+static bool key_less(const Keyed & a, const Keyed & b)
+{
+    return a.key < b.key;
+}
+
+/*
+ * Check that the merges keep equivalent elements in run order, splitting
+ * KEYED_VECTOR_SIZE elements with heavily duplicated keys into n_runs runs.
+ * The expected output is a stable sort of the runs concatenated in order.
+ */
+static void check_keyed_merge(size_t n_runs)
+{
+    size_t n_threads = std::thread::hardware_concurrency();
+    if (n_threads < 4) n_threads = 4;
+
+    std::vector<stll::vector<Keyed>> runs(n_runs);
+    std::vector<Keyed> expected;
+    for (size_t r = 0; r < n_runs; r++)
+    {
+        size_t n = KEYED_VECTOR_SIZE / n_runs;
+        std::vector<int> keys;
+        for (size_t i = 0; i < n; i++)
+        {
+            keys.push_back(random_numbers[r * n + i] % N_KEYS);
+        }
+        std::sort(keys.begin(), keys.end());
+
+        runs[r].ensure_capacity(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            Keyed k = {keys[i], r, i};
+            runs[r].emplace_back(k);
+            expected.push_back(k);
+        }
+    }
+    std::stable_sort(expected.begin(), expected.end(), key_less);
+
+    std::vector<Keyed> out(expected.size());
+    sll::kway_merge(runs, out.begin(), key_less);
+    if (out != expected)
+    {
+        std::cout << "ERROR: loser tree merge is not stable" << std::endl;
+    }
+
+    std::vector<Keyed> parallel_out(expected.size());
+    sll::parallel_kway_merge(runs, parallel_out.begin(), n_threads, key_less);
+    if (parallel_out != expected)
+    {
+        std::cout << "ERROR: parallel loser tree merge is not stable" << std::endl;
+    }
+
+    if (n_runs == 2)
+    {
+        std::vector<Keyed> two_way_out(expected.size());
+        sll::parallel_merge(runs[0].begin(), runs[0].end(),
+                runs[1].begin(), runs[1].end(), two_way_out.begin(),
+                n_threads, key_less);
+        if (two_way_out != expected)
+        {
+            std::cout << "ERROR: parallel two way merge is not stable" << std::endl;
+        }
+    }
+}
+
+/*
+ * Merge n_runs sorted runs of strings, long enough to live on the heap,
+ * and compare against sorting the concatenation. Strings aren't trivially
+ * copyable, so the loser tree refers to their heads through pointers.
+ */
+static void check_string_merge(size_t n_runs)
+{
+    size_t n_threads = std::thread::hardware_concurrency();
+    if (n_threads < 4) n_threads = 4;
+
+    std::vector<stll::vector<std::string>> runs(n_runs);
+    std::vector<std::string> expected;
+    for (size_t r = 0; r < n_runs; r++)
+    {
+        size_t n = KEYED_VECTOR_SIZE / n_runs;
+        std::vector<std::string> strings;
+        for (size_t i = 0; i < n; i++)
+        {
+            strings.push_back("merge test string "
+                    + std::to_string(random_numbers[r * n + i] % N_KEYS));
+        }
+        std::sort(strings.begin(), strings.end());
+
+        runs[r].ensure_capacity(n);
+        for (auto & x : strings)
+        {
+            runs[r].emplace_back(x);
+            expected.push_back(x);
+        }
+    }
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<std::string> out(expected.size());
+    sll::kway_merge(runs, out.begin());
+    if (out != expected)
+    {
+        std::cout << "ERROR: loser tree merge of strings is wrong" << std::endl;
+    }
+
+    std::vector<std::string> parallel_out(expected.size());
+    sll::parallel_kway_merge(runs, parallel_out.begin(), n_threads,
+            std::less<std::string>());
+    if (parallel_out != expected)
+    {
+        std::cout << "ERROR: parallel loser tree merge of strings is wrong"
+                  << std::endl;
+    }
+}
+
+/*
+ * Merge n_runs sorted runs which together hold MAX_VECTOR_SIZE random
+ * integers, comparing concatenating and sorting, a tree of pairwise
+ * std::merge passes, the loser tree merge and the parallel loser tree merge.
+ */
+ResultList test_merge(size_t n_runs)
+{
+    ResultList resultlist;
+    size_t n_threads = std::thread::hardware_concurrency();
+    if (n_threads == 0) n_threads = 1;
+
+    std::vector<stll::vector<int>> runs(n_runs);
+    for (size_t r = 0; r < n_runs; r++)
+    {
+        size_t start = MAX_VECTOR_SIZE * r / n_runs;
+        size_t end = MAX_VECTOR_SIZE * (r + 1) / n_runs;
+        runs[r].ensure_capacity(end - start);
+        for (size_t i = start; i < end; i++)
+        {
+            runs[r].emplace_back(random_numbers[i]);
+        }
+        std::sort(runs[r].begin(), runs[r].end());
+    }
+
+    // Concatenate all of the runs and sort them from scratch
+    init_start_time();
+    std::vector<int> expected;
+    expected.reserve(MAX_VECTOR_SIZE);
+    for (auto & run : runs)
+    {
+        expected.insert(expected.end(), run.begin(), run.end());
+    }
+    std::sort(expected.begin(), expected.end());
+    resultlist.emplace_back("Concatenate and sort time", get_time());
+
+    // Merge pairs of runs until there is only one left
+    init_start_time();
+    std::vector<std::vector<int>> pass;
+    for (auto & run : runs)
+    {
+        pass.emplace_back(run.begin(), run.end());
+    }
+    while (pass.size() > 1)
+    {
+        std::vector<std::vector<int>> next;
+        for (size_t i = 0; i + 1 < pass.size(); i += 2)
+        {
+            next.emplace_back(pass[i].size() + pass[i + 1].size());
+            std::merge(pass[i].begin(), pass[i].end(),
+                    pass[i + 1].begin(), pass[i + 1].end(), next.back().begin());
+        }
+        if (pass.size() % 2 == 1)
+        {
+            next.emplace_back(std::move(pass.back()));
+        }
+        pass = std::move(next);
+    }
+    resultlist.emplace_back("std::merge tree time", get_time());
+    check_merge(expected, pass[0], "std::merge tree");
+
+    std::vector<int> out(MAX_VECTOR_SIZE);
+    if (n_runs == 2)
+    {
+        init_start_time();
+        sll::merge(runs[0], runs[1], out.begin());
+        resultlist.emplace_back("Two way merge time", get_time());
+        check_merge(expected, out, "Two way merge");
+
+        std::fill(out.begin(), out.end(), 0);
+        init_start_time();
+        sll::parallel_merge(runs[0].begin(), runs[0].end(),
+                runs[1].begin(), runs[1].end(), out.begin(), n_threads);
+        resultlist.emplace_back("Parallel two way merge time", get_time());
+        check_merge(expected, out, "Parallel two way merge");
+    }
+
+    std::fill(out.begin(), out.end(), 0);
+    init_start_time();
+    sll::kway_merge(runs, out.begin());
+    resultlist.emplace_back("Loser tree merge time", get_time());
+    check_merge(expected, out, "Loser tree merge");
+
+    std::fill(out.begin(), out.end(), 0);
+    init_start_time();
+    sll::parallel_kway_merge(runs, out.begin(), n_threads);
+    resultlist.emplace_back("Parallel loser tree merge time", get_time());
+    check_merge(expected, out, "Parallel loser tree merge");
+
+    return resultlist;
+}
+
+
+int main()
+{
+    initialize_random_numbers();
+
+    for (size_t n_runs = MIN_RUNS; n_runs <= MAX_RUNS; n_runs *= 2)
+    {
+        check_keyed_merge(n_runs);
+        check_string_merge(n_runs);
+    }
+
+    for (size_t n_runs = MIN_RUNS; n_runs <= MAX_RUNS; n_runs *= 2)
+    {
+        ResultList merge_results = test_merge(n_runs);
+
+        std::cout << MAX_VECTOR_SIZE << " elements in " << n_runs
+            << " runs, merge times" << std::endl;
+
+        std::cout << merge_results << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,302 @@
+// TODO replace this with platform-agnostic version at
+// http://nadeausoftware.com/articles/2012/04/c_c_tip_how_measure_elapsed_real_time_benchmarking
+// or similar
+#include <sys/time.h>
+
+#include <algorithm>
+// Need malloc and rand
+#include <cstdlib>
+// Need for ostream
+#include <iostream>
+#include <list>
+
+// This is my test file
+#include "sl-packed-vector.hpp"
+
+constexpr size_t MAX_VECTOR_SIZE = 100000000;
+static int numbers[MAX_VECTOR_SIZE];
+static struct timeval start_time;
+
+/*
+ * Convenience function for setting the current time
+ */
+static void init_start_time(void)
+{
+    gettimeofday(&start_time, NULL);
+}
+
+/*
+ * Convenience function for getting the time since the last call to
+ * init_start_time
+ */
+static double get_time(void)
+{
+    struct timeval end_time;
+    gettimeofday(&end_time, NULL);
+    double diff = (double)(end_time.tv_sec - start_time.tv_sec)
+                + (double)(end_time.tv_usec - start_time.tv_usec) / 1e6;
+
+    return diff;
+}
+
+/*
+ * Initialize numbers in sorted order, with random gaps between 0 and
+ * max_gap - 1.
+ * A max_gap of 43 spreads MAX_VECTOR_SIZE numbers over the range of rand().
+ */
+static void initialize_sorted_numbers(int max_gap)
+{
+    int value = 0;
+    for (size_t i = 0; i < MAX_VECTOR_SIZE; i++)
+    {
+        value += rand() % max_gap;
+        numbers[i] = value;
+    }
+}
+
+/*
+ * Initialize numbers in clusters of CLUSTER_SIZE, each spread randomly over
+ * spread values above a random base. The numbers are unsorted, so blocks
+ * pack as offsets from their minimum rather than as deltas. A spread of
+ * RAND_MAX makes every number random.
+ */
+static void initialize_clustered_numbers(int spread)
+{
+    constexpr size_t CLUSTER_SIZE = 1000;
+    int base = 0;
+    for (size_t i = 0; i < MAX_VECTOR_SIZE; i++)
+    {
+        if (i % CLUSTER_SIZE == 0)
+        {
+            base = rand() % (RAND_MAX - spread + 1);
+        }
+        numbers[i] = base + rand() % spread;
+    }
+}
+
+struct TimeResult
+{
+    public:
+        std::string tag;
+        double time;
+        TimeResult(std::string tag, double time)
+        {
+            this->tag = tag;
+            this->time = time;
+        }
+};
+
+class ResultList : public std::list<TimeResult>
+{
+};
+
+std::ostream& operator<< (std::ostream & o, ResultList r)
+{
+    for (auto tr : r)
+    {
+        o << tr.tag << ": " << tr.time << std::endl;
+    }
+    return o;
+}
+
+/*
+ * Compare the size, append, scan and random access speed of a plain vector
+ * and a packed vector holding the first n numbers. Scan rates are reported
+ * in GB/s of uncompressed integers. lower_bound is only checked when the
+ * numbers are sorted.
+ */
+ResultList test_packed_vector(size_t n, bool sorted)
+{
+    ResultList resultlist;
+    double gb = n * sizeof(int) / 1e9;
+
+    stll::vector<int> vec;
+    init_start_time();
+    for (size_t i = 0; i < n; i++)
+    {
+        vec.emplace_back(numbers[i]);
+    }
+    resultlist.emplace_back("Vector push time", get_time());
+
+    stll::packed_vector<int> packed;
+    init_start_time();
+    for (size_t i = 0; i < n; i++)
+    {
+        packed.emplace_back(numbers[i]);
+    }
+    resultlist.emplace_back("Packed push time", get_time());
+
+    // The packed buffers grow by doubling like any vector, so report the
+    // ratio both as appended and once the spare capacity is released
+    double vec_bytes = (double)(vec.size() * sizeof(int));
+    resultlist.emplace_back("Vector MB", vec_bytes / 1e6);
+    resultlist.emplace_back("Packed MB", packed.memory_usage() / 1e6);
+    resultlist.emplace_back("Compression ratio",
+            vec_bytes / packed.memory_usage());
+
+    init_start_time();
+    packed.shrink_to_fit();
+    resultlist.emplace_back("Packed shrink_to_fit time", get_time());
+    resultlist.emplace_back("Packed MB after shrink_to_fit",
+            packed.memory_usage() / 1e6);
+    resultlist.emplace_back("Compression ratio after shrink_to_fit",
+            vec_bytes / packed.memory_usage());
+
+    long long vec_sum = 0;
+    init_start_time();
+    for (auto x : vec)
+    {
+        vec_sum += x;
+    }
+    resultlist.emplace_back("Vector scan GB/s", gb / get_time());
+
+    long long iter_sum = 0;
+    init_start_time();
+    for (auto x : packed)
+    {
+        iter_sum += x;
+    }
+    resultlist.emplace_back("Packed iterator scan GB/s", gb / get_time());
+
+    long long block_sum = 0;
+    int buffer[stll::packed_vector<int>::BLOCK_SIZE];
+    init_start_time();
+    for (size_t b = 0; b < packed.block_count(); b++)
+    {
+        size_t n = packed.decode_block(b, buffer);
+        for (size_t i = 0; i < n; i++)
+        {
+            block_sum += buffer[i];
+        }
+    }
+    resultlist.emplace_back("Packed block decode GB/s", gb / get_time());
+
+    constexpr size_t N_LOOKUPS = 10000000;
+    long long vec_lookup_sum = 0;
+    init_start_time();
+    for (size_t i = 0; i < N_LOOKUPS; i++)
+    {
+        vec_lookup_sum += vec[(i * 7919) % n];
+    }
+    resultlist.emplace_back("Vector random access time", get_time());
+
+    long long packed_lookup_sum = 0;
+    init_start_time();
+    for (size_t i = 0; i < N_LOOKUPS; i++)
+    {
+        packed_lookup_sum += packed[(i * 7919) % n];
+    }
+    resultlist.emplace_back("Packed random access time", get_time());
+
+    // Search for values spread over the whole range, including ones past
+    // the end
+    size_t lower_bound_errors = 0;
+    long long vec_search_sum = 0;
+    long long packed_search_sum = 0;
+    if (sorted)
+    {
+        int max_value = numbers[n - 1];
+        init_start_time();
+        for (size_t i = 0; i < N_LOOKUPS; i++)
+        {
+            int value = (int)((i * 7919) % ((size_t)max_value + 2));
+            vec_search_sum += std::lower_bound(numbers,
+                    numbers + n, value) - numbers;
+        }
+        resultlist.emplace_back("Vector lower_bound time", get_time());
+
+        init_start_time();
+        for (size_t i = 0; i < N_LOOKUPS; i++)
+        {
+            int value = (int)((i * 7919) % ((size_t)max_value + 2));
+            packed_search_sum += packed.lower_bound(value);
+        }
+        resultlist.emplace_back("Packed lower_bound time", get_time());
+
+        for (size_t i = 0; i < N_LOOKUPS; i += 997)
+        {
+            int value = (int)((i * 7919) % ((size_t)max_value + 2));
+            size_t expected = std::lower_bound(numbers,
+                    numbers + n, value) - numbers;
+            if (packed.lower_bound(value) != expected)
+            {
+                lower_bound_errors ++;
+            }
+        }
+    }
+
+    size_t block_errors = 0;
+    constexpr size_t BLOCK_SIZE = stll::packed_vector<int>::BLOCK_SIZE;
+    for (size_t b = 0; b < packed.block_count(); b++)
+    {
+        const int * first = numbers + b * BLOCK_SIZE;
+        const int * last = numbers + std::min((b + 1) * BLOCK_SIZE, n);
+        if (packed.block_min(b) != *std::min_element(first, last)
+                || packed.block_max(b) != *std::max_element(first, last))
+        {
+            block_errors ++;
+        }
+    }
+
+    // The random lookups rarely land in the uncompressed tail, so check the
+    // last two blocks by index
+    size_t index_errors = 0;
+    for (size_t i = n - std::min(n, 2 * BLOCK_SIZE); i < n; i++)
+    {
+        if (packed[i] != numbers[i])
+        {
+            index_errors ++;
+        }
+    }
+
+    if (vec_sum != iter_sum || vec_sum != block_sum
+            || vec_lookup_sum != packed_lookup_sum || index_errors > 0)
+    {
+        std::cout << "ERROR: packed vector contents differ" << std::endl;
+    }
+    if (vec_search_sum != packed_search_sum || lower_bound_errors > 0)
+    {
+        std::cout << "ERROR: packed lower_bound differs from std::lower_bound"
+                  << std::endl;
+    }
+    if (block_errors > 0)
+    {
+        std::cout << "ERROR: " << block_errors
+                  << " packed blocks have the wrong min or max" << std::endl;
+    }
+
+    return resultlist;
+}
+
+
+int main()
+{
+    initialize_sorted_numbers(43);
+    ResultList sparse = test_packed_vector(MAX_VECTOR_SIZE, true);
+    std::cout << MAX_VECTOR_SIZE << " sorted integers, gaps up to 42" << std::endl;
+    std::cout << sparse;
+
+    initialize_sorted_numbers(4);
+    ResultList dense = test_packed_vector(MAX_VECTOR_SIZE, true);
+    std::cout << "\n\n";
+    std::cout << MAX_VECTOR_SIZE << " sorted integers, gaps up to 3" << std::endl;
+    std::cout << dense;
+
+    // A size which isn't a multiple of the block size leaves values in the
+    // uncompressed tail
+    constexpr size_t UNEVEN_SIZE = MAX_VECTOR_SIZE - 37;
+
+    initialize_clustered_numbers(1000);
+    ResultList clustered = test_packed_vector(UNEVEN_SIZE, false);
+    std::cout << "\n\n";
+    std::cout << UNEVEN_SIZE << " clustered integers, spread 1000" << std::endl;
+    std::cout << clustered;
+
+    initialize_clustered_numbers(RAND_MAX);
+    ResultList random = test_packed_vector(UNEVEN_SIZE, false);
+    std::cout << "\n\n";
+    std::cout << UNEVEN_SIZE << " random integers" << std::endl;
+    std::cout << random;
+
+    return 0;
+}
@@ -0,0 +1,227 @@
+// TODO replace this with platform-agnostic version at
+// http://nadeausoftware.com/articles/2012/04/c_c_tip_how_measure_elapsed_real_time_benchmarking
+// or similar
+#include <sys/time.h>
+
+// Need malloc and rand
+#include <cstdlib>
+// Need for ostream
+#include <iostream>
+#include <list>
+
+// This is what I'm using to compare to
+#include <algorithm>
+#include <vector>
+
+// This is my test file
+#include "sl-search.hpp"
+
+// Searches are benchmarked on sorted arrays from MIN_SEARCH_SIZE up to
+// MAX_SEARCH_SIZE elements, growing by SEARCH_SIZE_STEP each time. The index
+// needs the same memory as the sorted array, so going up to 1B elements
+// needs ~8GB of RAM; bump MAX_SEARCH_SIZE if you have it.
+constexpr size_t MIN_SEARCH_SIZE = 1 << 10;
+constexpr size_t MAX_SEARCH_SIZE = 1 << 28;
+constexpr size_t SEARCH_SIZE_STEP = 4;
+constexpr size_t N_QUERIES = 1 << 22;
+// Every size up to MAX_CHECK_SIZE is checked exhaustively, so that the
+// bottom level of the tree is seen partly filled in every way
+constexpr size_t MAX_CHECK_SIZE = 600;
+static int queries[N_QUERIES];
+static size_t results[N_QUERIES];
+static struct timeval start_time;
+
+/*
+ * Convenience function for setting the current time
+ */
+static void init_start_time(void)
+{
+    gettimeofday(&start_time, NULL);
+}
+
+/*
+ * Convenience function for getting the time since the last call to
+ * init_start_time
+ */
+static double get_time(void)
+{
+    struct timeval end_time;
+    gettimeofday(&end_time, NULL);
+    double diff = (double)(end_time.tv_sec - start_time.tv_sec)
+                + (double)(end_time.tv_usec - start_time.tv_usec) / 1e6;
+
+    return diff;
+}
+
+/*
+ * Initialize the random queries used in the rest of the testing
+ */
+static void initialize_queries(void)
+{
+    for (size_t i = 0; i < N_QUERIES; i++)
+    {
+        queries[i] = (int)rand();
+    }
+}
+
+struct TimeResult
+{
+    public:
+        std::string tag;
+        double time;
+        TimeResult(std::string tag, double time)
+        {
+            this->tag = tag;
+            this->time = time;
+        }
+};
+
+class ResultList : public std::list<TimeResult>
+{
+};
+
+std::ostream& operator<< (std::ostream & o, ResultList r)
+{
+    for (auto tr : r)
+    {
+        o << tr.tag << ": " << tr.time << std::endl;
+    }
+    return o;
+}
+
+/*
+ * Check an index ordered by Compare over n even numbers against
+ * std::lower_bound, querying every number in the range and one past each
+ * end. Returns the number of mismatched lookups.
+ */
+template <class Compare>
+static size_t check_search_index(size_t n)
+{
+    std::vector<int> sorted(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        sorted[i] = 2 * (int)i;
+    }
+    std::sort(sorted.begin(), sorted.end(), Compare());
+    sll::static_search_index<int, Compare> index(sorted.begin(), sorted.end());
+
+    std::vector<int> check_queries;
+    for (int x = -1; x <= 2 * (int)n; x++)
+    {
+        check_queries.push_back(x);
+    }
+    std::vector<size_t> batch(check_queries.size());
+    index.lower_bound(check_queries.data(), check_queries.size(), batch.data());
+
+    size_t errors = 0;
+    for (size_t i = 0; i < check_queries.size(); i++)
+    {
+        size_t expected = std::lower_bound(sorted.begin(), sorted.end(),
+                check_queries[i], Compare()) - sorted.begin();
+        errors += index.lower_bound(check_queries[i]) != expected;
+        errors += batch[i] != expected;
+        errors += index.contains(check_queries[i]) != std::binary_search(
+                sorted.begin(), sorted.end(), check_queries[i], Compare());
+    }
+    return errors;
+}
+
+/*
+ * Time N_QUERIES lookups into a sorted array of n random integers, using
+ * std::lower_bound, the Eytzinger index one query at a time, and the
+ * Eytzinger index with batched queries. Every lookup is checked against
+ * std::lower_bound.
+ */
+ResultList test_search(size_t n)
+{
+    ResultList resultlist;
+
+    std::vector<int> sorted(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        sorted[i] = (int)rand();
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    init_start_time();
+    sll::static_search_index<int> index(sorted.begin(), sorted.end());
+    resultlist.emplace_back("Index build time", get_time());
+
+    size_t checksum = 0;
+    init_start_time();
+    for (size_t i = 0; i < N_QUERIES; i++)
+    {
+        results[i] = std::lower_bound(sorted.begin(), sorted.end(), queries[i])
+            - sorted.begin();
+    }
+    resultlist.emplace_back("std::lower_bound time", get_time());
+
+    size_t errors = 0;
+    init_start_time();
+    for (size_t i = 0; i < N_QUERIES; i++)
+    {
+        checksum += index.lower_bound(queries[i]);
+    }
+    resultlist.emplace_back("Eytzinger lower_bound time", get_time());
+
+    for (size_t i = 0; i < N_QUERIES; i++)
+    {
+        errors += index.lower_bound(queries[i]) != results[i];
+        errors += index.contains(queries[i]) != std::binary_search(
+                sorted.begin(), sorted.end(), queries[i]);
+    }
+
+    static size_t batch_results[N_QUERIES];
+    init_start_time();
+    index.lower_bound(queries, N_QUERIES, batch_results);
+    resultlist.emplace_back("Eytzinger batched lower_bound time", get_time());
+
+    for (size_t i = 0; i < N_QUERIES; i++)
+    {
+        errors += batch_results[i] != results[i];
+    }
+
+    if (errors != 0)
+    {
+        std::cout << "ERROR: " << errors << " mismatched lookups" << std::endl;
+    }
+    // Keep the timed loop from being optimized away
+    std::cout << "checksum " << checksum << std::endl;
+
+    return resultlist;
+}
+
+
+int main()
+{
+    initialize_queries();
+
+    size_t errors = 0;
+    for (size_t n = 0; n <= MAX_CHECK_SIZE; n++)
+    {
+        errors += check_search_index<std::less<int>>(n);
+        errors += check_search_index<std::greater<int>>(n);
+    }
+    if (errors != 0)
+    {
+        std::cout << "ERROR: " << errors
+                  << " mismatched lookups in small indexes" << std::endl;
+    }
+
+    // Benchmark powers of two, which leave one node on the bottom level,
+    // and two thirds of them, which leave it about a third full
+    for (size_t n = MIN_SEARCH_SIZE; n <= MAX_SEARCH_SIZE; n *= SEARCH_SIZE_STEP)
+    {
+        for (size_t size : {n - n / 3, n})
+        {
+            ResultList search_results = test_search(size);
+
+            std::cout << size << " element search times (" << N_QUERIES
+                << " queries)" << std::endl;
+
+            std::cout << search_results << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,625 @@
+/*
+ * Experimentation with merging sorted runs, using the STL library for
+ * comparison
+ */
+#ifndef SL_MERGE_HPP
+#define SL_MERGE_HPP
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "sl-vector.hpp"
+
+namespace sll
+{
+/**
+ * Merge the sorted ranges [start1, end1) and [start2, end2) into out,
+ * according to the binary operator c. The merge is stable, so equivalent
+ * elements from the first range come before those from the second.
+ *
+ * Returns the end of the output range.
+ */
+template <class InputIterator1, class InputIterator2, class OutputIterator,
+         class Compare>
+OutputIterator merge(InputIterator1 start1, InputIterator1 end1,
+        InputIterator2 start2, InputIterator2 end2, OutputIterator out,
+        Compare c);
+
+/**
+ * Merge the sorted ranges according to the default less operator.
+ */
+template <class InputIterator1, class InputIterator2, class OutputIterator>
+OutputIterator merge(InputIterator1 start1, InputIterator1 end1,
+        InputIterator2 start2, InputIterator2 end2, OutputIterator out);
+
+/**
+ * Merge the sorted containers a and b into out according to c.
+ */
+template <class Range1, class Range2, class OutputIterator, class Compare>
+OutputIterator merge(const Range1 & a, const Range2 & b, OutputIterator out,
+        Compare c);
+
+/**
+ * Merge the sorted containers a and b into out according to the default
+ * less operator.
+ */
+template <class Range1, class Range2, class OutputIterator>
+OutputIterator merge(const Range1 & a, const Range2 & b, OutputIterator out);
+
+/**
+ * Merge any number of sorted runs into out, according to c. ranges is a
+ * container of runs, each of which must provide begin() and end(), for
+ * example a stll::vector<stll::vector<int>> of shards.
+ *
+ * The runs are merged with a loser tree, so each output element costs
+ * log2(k) comparisons for k runs, and the comparisons only ever touch the
+ * current head of each run. Equivalent elements are output in the order
+ * of the runs they came from.
+ */
+template <class RangeContainer, class OutputIterator, class Compare>
+OutputIterator kway_merge(const RangeContainer & ranges, OutputIterator out,
+        Compare c);
+
+/**
+ * Merge any number of sorted runs into out according to the default less
+ * operator.
+ */
+template <class RangeContainer, class OutputIterator>
+OutputIterator kway_merge(const RangeContainer & ranges, OutputIterator out);
+
+/**
+ * Merge two sorted ranges into the random access range starting at out
+ * using n_threads threads. The output is cut into n_threads equal slices,
+ * and the start of each slice is located in both inputs with a merge path
+ * binary search, so each thread merges independently into its own slice.
+ */
+template <class RandomAccessIterator1, class RandomAccessIterator2,
+         class RandomAccessIterator3, class Compare>
+RandomAccessIterator3 parallel_merge(RandomAccessIterator1 start1,
+        RandomAccessIterator1 end1, RandomAccessIterator2 start2,
+        RandomAccessIterator2 end2, RandomAccessIterator3 out,
+        size_t n_threads, Compare c);
+
+template <class RandomAccessIterator1, class RandomAccessIterator2,
+         class RandomAccessIterator3>
+RandomAccessIterator3 parallel_merge(RandomAccessIterator1 start1,
+        RandomAccessIterator1 end1, RandomAccessIterator2 start2,
+        RandomAccessIterator2 end2, RandomAccessIterator3 out,
+        size_t n_threads);
+
+/**
+ * Merge any number of sorted runs into the random access range starting at
+ * out using n_threads threads. The start of each thread's output slice is
+ * located in every run by co-ranking, then each thread runs its own loser
+ * tree over its part of the runs.
+ */
+template <class RangeContainer, class RandomAccessIterator, class Compare>
+RandomAccessIterator parallel_kway_merge(const RangeContainer & ranges,
+        RandomAccessIterator out, size_t n_threads, Compare c);
+
+template <class RangeContainer, class RandomAccessIterator>
+RandomAccessIterator parallel_kway_merge(const RangeContainer & ranges,
+        RandomAccessIterator out, size_t n_threads);
+
+/**
+ * Find the number of elements i taken from the first range in the first d
+ * elements of the stable merge of the two ranges. The remaining d - i
+ * elements come from the second range.
+ */
+template <class RandomAccessIterator1, class RandomAccessIterator2,
+         class Compare>
+size_t merge_path_corank(size_t d, RandomAccessIterator1 start1, size_t n1,
+        RandomAccessIterator2 start2, size_t n2, Compare c);
+
+/**
+ * Find, for every run k, the number of elements split[k] taken from run k
+ * in the first d elements of the stable merge of all of the runs. split
+ * must have room for one entry per run.
+ */
+template <class RandomAccessIterator, class Compare>
+void kway_corank(size_t d, const stll::vector<RandomAccessIterator> & starts,
+        const stll::vector<RandomAccessIterator> & ends, size_t * split,
+        Compare c);
+
+/**
+ * Get b ? x : y. Integers are picked with a mask rather than a conditional,
+ * since the outcome of a merge comparison is unpredictable and compilers
+ * tend to turn a conditional back into a branch.
+ */
+template <class T>
+typename std::enable_if<std::is_integral<T>::value
+        && !std::is_same<T, bool>::value, T>::type select_value(
+        bool b, T x, T y) noexcept;
+
+template <class T>
+typename std::enable_if<!std::is_integral<T>::value
+        || std::is_same<T, bool>::value, const T &>::type
+select_value(bool b, const T & x, const T & y) noexcept;
+
+/**
+ * How loser_tree_merge caches the head of a run. Trivially copyable values
+ * are copied, so that matches compare values already in registers. Any
+ * other type is pointed to, so that replaying a path never copies one.
+ */
+template <class T, bool BY_VALUE = std::is_trivially_copyable<T>::value>
+struct merge_head
+{
+    typedef T type;
+
+    template <class Iterator>
+    static type get(const Iterator & i)
+    {
+        return *i;
+    }
+
+    static const T & value(const type & h) noexcept
+    {
+        return h;
+    }
+};
+
+template <class T>
+struct merge_head<T, false>
+{
+    typedef const T * type;
+
+    template <class Iterator>
+    static type get(const Iterator & i)
+    {
+        return &*i;
+    }
+
+    static const T & value(type h) noexcept
+    {
+        return *h;
+    }
+};
+
+/**
+ * Merge the runs [starts[k], ends[k]) with a loser tree. starts is used as
+ * the cursor for each run, so it is consumed by the merge. The elements of
+ * a run must stay in place while its iterator moves past them.
+ */
+template <class InputIterator, class OutputIterator, class Compare>
+OutputIterator loser_tree_merge(stll::vector<InputIterator> & starts,
+        const stll::vector<InputIterator> & ends, OutputIterator out,
+        Compare c);
+
+
+template <class InputIterator1, class InputIterator2, class OutputIterator,
+         class Compare>
+OutputIterator merge(InputIterator1 start1, InputIterator1 end1,
+        InputIterator2 start2, InputIterator2 end2, OutputIterator out,
+        Compare c)
+{
+    while (start1 != end1 && start2 != end2)
+    {
+        // Take from the second range only if it is strictly smaller, so
+        // that ties keep the first range first
+        if (c(*start2, *start1))
+        {
+            *out = *start2;
+            ++ start2;
+        }
+        else
+        {
+            *out = *start1;
+            ++ start1;
+        }
+        ++ out;
+    }
+    for (; start1 != end1; ++start1, ++out)
+    {
+        *out = *start1;
+    }
+    for (; start2 != end2; ++start2, ++out)
+    {
+        *out = *start2;
+    }
+    return out;
+}
+
+template <class InputIterator1, class InputIterator2, class OutputIterator>
+OutputIterator merge(InputIterator1 start1, InputIterator1 end1,
+        InputIterator2 start2, InputIterator2 end2, OutputIterator out)
+{
+    return sll::merge(start1, end1, start2, end2, out,
+            std::less<typename std::iterator_traits<InputIterator1>::value_type>());
+}
+
+template <class Range1, class Range2, class OutputIterator, class Compare>
+OutputIterator merge(const Range1 & a, const Range2 & b, OutputIterator out,
+        Compare c)
+{
+    return sll::merge(a.begin(), a.end(), b.begin(), b.end(), out, c);
+}
+
+template <class Range1, class Range2, class OutputIterator>
+OutputIterator merge(const Range1 & a, const Range2 & b, OutputIterator out)
+{
+    return sll::merge(a.begin(), a.end(), b.begin(), b.end(), out);
+}
+
+template <class RangeContainer, class OutputIterator, class Compare>
+OutputIterator kway_merge(const RangeContainer & ranges, OutputIterator out,
+        Compare c)
+{
+    typedef decltype(ranges.begin()->begin()) InputIterator;
+    stll::vector<InputIterator> starts;
+    stll::vector<InputIterator> ends;
+    for (auto & r : ranges)
+    {
+        starts.emplace_back(r.begin());
+        ends.emplace_back(r.end());
+    }
+    return loser_tree_merge(starts, ends, out, c);
+}
+
+template <class RangeContainer, class OutputIterator>
+OutputIterator kway_merge(const RangeContainer & ranges, OutputIterator out)
+{
+    typedef decltype(ranges.begin()->begin()) InputIterator;
+    return kway_merge(ranges, out,
+            std::less<typename std::iterator_traits<InputIterator>::value_type>());
+}
+
+template <class T>
+typename std::enable_if<std::is_integral<T>::value
+        && !std::is_same<T, bool>::value, T>::type select_value(
+        bool b, T x, T y) noexcept
+{
+    typedef typename std::make_unsigned<T>::type U;
+    U mask = (U)0 - (U)b;
+    return (T)((U)y ^ (((U)x ^ (U)y) & mask));
+}
+
+template <class T>
+typename std::enable_if<!std::is_integral<T>::value
+        || std::is_same<T, bool>::value, const T &>::type
+select_value(bool b, const T & x, const T & y) noexcept
+{
+    return b ? x : y;
+}
+
+template <class InputIterator, class OutputIterator, class Compare>
+OutputIterator loser_tree_merge(stll::vector<InputIterator> & starts,
+        const stll::vector<InputIterator> & ends, OutputIterator out,
+        Compare c)
+{
+    typedef typename std::iterator_traits<InputIterator>::value_type T;
+    typedef merge_head<T> Head;
+    typedef typename Head::type H;
+
+    size_t k = starts.size();
+    size_t remaining = 0;
+    size_t first_live = k;
+    for (size_t i = 0; i < k; i++)
+    {
+        size_t n = std::distance(starts[i], ends[i]);
+        remaining += n;
+        if (n > 0 && first_live == k) first_live = i;
+    }
+    if (remaining == 0) return out;
+
+    // Cache the head of each run, so matches read one flat array rather
+    // than going through the run iterators. Exhausted runs are flagged
+    // dead and keep a stale head, empty runs borrow one so that T needn't
+    // be default constructible.
+    stll::vector<H> head;
+    stll::vector<char> dead;
+    head.ensure_capacity(k);
+    dead.ensure_capacity(k);
+    for (size_t i = 0; i < k; i++)
+    {
+        bool empty = starts[i] == ends[i];
+        head.emplace_back(Head::get(starts[empty ? first_live : i]));
+        dead.emplace_back((char)empty);
+    }
+
+    // Run o, stored at a node, beats the challenger w if its head comes
+    // first in the merged output. Dead runs lose to everything. Ties go to
+    // the earlier run, so if o is earlier it wins unless w is strictly
+    // smaller, and otherwise only if it is strictly smaller. Picking the
+    // operands by run order makes that a single comparison.
+    auto beats = [c](size_t o, const H & o_head, bool o_dead,
+            size_t w, const H & w_head, bool w_dead) {
+        if (o_dead | w_dead) return !o_dead;
+        bool o_first = o < w;
+        return o_first != c(Head::value(select_value(o_first, w_head, o_head)),
+                Head::value(select_value(o_first, o_head, w_head)));
+    };
+
+    // The tree is stored like a heap: run i is the leaf at node k + i, the
+    // internal nodes 1 .. k - 1 hold the loser of the match played there.
+    // winner[n] is the run that won at node n, only needed while building.
+    stll::vector<size_t> tree;
+    stll::vector<size_t> winner;
+    tree.ensure_capacity(k);
+    winner.ensure_capacity(2 * k);
+    for (size_t n = 0; n < 2 * k; n++)
+    {
+        winner.emplace_back(n >= k ? n - k : 0);
+    }
+    for (size_t n = 0; n < k; n++)
+    {
+        tree.emplace_back((size_t)0);
+    }
+    for (size_t n = k - 1; n >= 1; n--)
+    {
+        size_t l = winner[2 * n];
+        size_t r = winner[2 * n + 1];
+        bool left = beats(l, head[l], dead[l], r, head[r], dead[r]);
+        tree[n] = select_value(left, r, l);
+        winner[n] = select_value(left, l, r);
+    }
+
+    // The winner's head is carried up the tree rather than looked up at
+    // every level, so the only loads on the path are the stored losers,
+    // whose addresses don't depend on the matches played below them
+    size_t w = winner[1];
+    H w_head = head[w];
+    bool w_dead = false;
+    for (; remaining > 0; remaining--)
+    {
+        *out = Head::value(w_head);
+        ++ out;
+        ++ starts[w];
+        if (starts[w] != ends[w])
+        {
+            w_head = Head::get(starts[w]);
+            head[w] = w_head;
+        }
+        else
+        {
+            w_dead = true;
+            dead[w] = 1;
+        }
+
+        // Only the path from w's leaf to the root changed, so replay the
+        // matches against the stored losers on that path
+        for (size_t n = (w + k) / 2; n >= 1; n /= 2)
+        {
+            size_t o = tree[n];
+            H o_head = head[o];
+            bool swap = beats(o, o_head, dead[o], w, w_head, w_dead);
+            tree[n] = select_value(swap, w, o);
+            w = select_value(swap, o, w);
+            w_head = select_value(swap, o_head, w_head);
+            // Only a live run can beat w
+            w_dead = w_dead && !swap;
+        }
+    }
+    return out;
+}
+
+template <class RandomAccessIterator1, class RandomAccessIterator2,
+         class Compare>
+size_t merge_path_corank(size_t d, RandomAccessIterator1 start1, size_t n1,
+        RandomAccessIterator2 start2, size_t n2, Compare c)
+{
+    size_t lo = d > n2 ? d - n2 : 0;
+    size_t hi = d < n1 ? d : n1;
+    while (lo < hi)
+    {
+        size_t i = lo + (hi - lo) / 2;
+        size_t j = d - i;
+        // If start1[i] <= start2[j - 1] it precedes the last element we
+        // would take from the second range, so more of the first is needed
+        if (j > 0 && !c(start2[j - 1], start1[i]))
+        {
+            lo = i + 1;
+        }
+        else
+        {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+template <class RandomAccessIterator1, class RandomAccessIterator2,
+         class RandomAccessIterator3, class Compare>
+RandomAccessIterator3 parallel_merge(RandomAccessIterator1 start1,
+        RandomAccessIterator1 end1, RandomAccessIterator2 start2,
+        RandomAccessIterator2 end2, RandomAccessIterator3 out,
+        size_t n_threads, Compare c)
+{
+    size_t n1 = end1 - start1;
+    size_t n2 = end2 - start2;
+    size_t total = n1 + n2;
+    if (n_threads <= 1 || total < n_threads)
+    {
+        return sll::merge(start1, end1, start2, end2, out, c);
+    }
+
+    stll::vector<std::thread> threads;
+    threads.ensure_capacity(n_threads);
+    for (size_t t = 0; t < n_threads; t++)
+    {
+        size_t d_start = total * t / n_threads;
+        size_t d_end = total * (t + 1) / n_threads;
+        threads.emplace_back([=]() {
+            size_t i_start = merge_path_corank(d_start, start1, n1, start2, n2, c);
+            size_t i_end = merge_path_corank(d_end, start1, n1, start2, n2, c);
+            sll::merge(start1 + i_start, start1 + i_end,
+                    start2 + (d_start - i_start), start2 + (d_end - i_end),
+                    out + d_start, c);
+        });
+    }
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+    return out + total;
+}
+
+template <class RandomAccessIterator1, class RandomAccessIterator2,
+         class RandomAccessIterator3>
+RandomAccessIterator3 parallel_merge(RandomAccessIterator1 start1,
+        RandomAccessIterator1 end1, RandomAccessIterator2 start2,
+        RandomAccessIterator2 end2, RandomAccessIterator3 out,
+        size_t n_threads)
+{
+    return parallel_merge(start1, end1, start2, end2, out, n_threads,
+            std::less<typename std::iterator_traits<RandomAccessIterator1>::value_type>());
+}
+
+template <class RandomAccessIterator, class Compare>
+void kway_corank(size_t d, const stll::vector<RandomAccessIterator> & starts,
+        const stll::vector<RandomAccessIterator> & ends, size_t * split,
+        Compare c)
+{
+    size_t k = starts.size();
+    // The answer for run s always lies in [lo[s], hi[s]]
+    stll::vector<size_t> lo;
+    stll::vector<size_t> hi;
+    stll::vector<size_t> pos;
+    for (size_t s = 0; s < k; s++)
+    {
+        lo.emplace_back((size_t)0);
+        hi.emplace_back((size_t)(ends[s] - starts[s]));
+        pos.emplace_back((size_t)0);
+    }
+
+    while (true)
+    {
+        // Pivot on the middle of the widest remaining window, so it halves
+        size_t r = 0;
+        for (size_t s = 1; s < k; s++)
+        {
+            if (hi[s] - lo[s] > hi[r] - lo[r]) r = s;
+        }
+        if (hi[r] == lo[r]) break;
+        size_t m = lo[r] + (hi[r] - lo[r]) / 2;
+        auto & v = starts[r][m];
+
+        // Count the elements before (v, r, m) in the stable merge. Earlier
+        // runs win ties, so they contribute everything <= v, later runs
+        // only contribute elements < v.
+        size_t rank = 0;
+        for (size_t s = 0; s < k; s++)
+        {
+            if (s == r)
+            {
+                pos[s] = m;
+            }
+            else
+            {
+                auto b = starts[s] + lo[s];
+                auto e = starts[s] + hi[s];
+                if (s < r)
+                {
+                    pos[s] = std::upper_bound(b, e, v, c) - starts[s];
+                }
+                else
+                {
+                    pos[s] = std::lower_bound(b, e, v, c) - starts[s];
+                }
+            }
+            rank += pos[s];
+        }
+
+        // If v lands inside the first d elements, everything before it does
+        // too, otherwise nothing from v onwards does
+        for (size_t s = 0; s < k; s++)
+        {
+            if (rank < d)
+            {
+                lo[s] = s == r ? m + 1 : pos[s];
+            }
+            else
+            {
+                hi[s] = pos[s];
+            }
+        }
+    }
+
+    for (size_t s = 0; s < k; s++)
+    {
+        split[s] = lo[s];
+    }
+}
+
+template <class RangeContainer, class RandomAccessIterator, class Compare>
+RandomAccessIterator parallel_kway_merge(const RangeContainer & ranges,
+        RandomAccessIterator out, size_t n_threads, Compare c)
+{
+    typedef decltype(ranges.begin()->begin()) InputIterator;
+    stll::vector<InputIterator> starts;
+    stll::vector<InputIterator> ends;
+    size_t total = 0;
+    for (auto & r : ranges)
+    {
+        starts.emplace_back(r.begin());
+        ends.emplace_back(r.end());
+        total += r.end() - r.begin();
+    }
+    if (n_threads <= 1 || total < n_threads)
+    {
+        return loser_tree_merge(starts, ends, out, c);
+    }
+
+    // splits[t * k + s] holds the co-rank of the start of slice t in run s
+    size_t k = starts.size();
+    stll::vector<size_t> splits;
+    splits.ensure_capacity((n_threads + 1) * k);
+    for (size_t i = 0; i < (n_threads + 1) * k; i++)
+    {
+        splits.emplace_back((size_t)0);
+    }
+
+    stll::vector<std::thread> threads;
+    threads.ensure_capacity(n_threads);
+    for (size_t t = 0; t < n_threads; t++)
+    {
+        threads.emplace_back([&, t]() {
+            kway_corank(total * t / n_threads, starts, ends,
+                    splits.begin() + t * k, c);
+        });
+    }
+    kway_corank(total, starts, ends, splits.begin() + n_threads * k, c);
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+    while (!threads.empty())
+    {
+        threads.pop_back();
+    }
+
+    for (size_t t = 0; t < n_threads; t++)
+    {
+        threads.emplace_back([&, t]() {
+            stll::vector<InputIterator> slice_starts;
+            stll::vector<InputIterator> slice_ends;
+            for (size_t s = 0; s < k; s++)
+            {
+                slice_starts.emplace_back(starts[s] + splits[t * k + s]);
+                slice_ends.emplace_back(starts[s] + splits[(t + 1) * k + s]);
+            }
+            loser_tree_merge(slice_starts, slice_ends,
+                    out + total * t / n_threads, c);
+        });
+    }
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+    return out + total;
+}
+
+template <class RangeContainer, class RandomAccessIterator>
+RandomAccessIterator parallel_kway_merge(const RangeContainer & ranges,
+        RandomAccessIterator out, size_t n_threads)
+{
+    typedef decltype(ranges.begin()->begin()) InputIterator;
+    return parallel_kway_merge(ranges, out, n_threads,
+            std::less<typename std::iterator_traits<InputIterator>::value_type>());
+}
+}
+
+#endif
@@ -0,0 +1,650 @@
+/*
+ * Experimentation with compressed storage of integer columns
+ */
+#ifndef SL_PACKED_VECTOR_HPP
+#define SL_PACKED_VECTOR_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#include "sl-vector.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SL_PACKED_VECTOR_AVX2
+#include <immintrin.h>
+#endif
+
+// STL learning namespace
+namespace stll
+{
+
+/**
+ * Get the 64 bits of words starting at bit pos. words[pos / 64 + 1] must be
+ * readable.
+ */
+inline uint64_t bit_extract(const uint64_t * words, size_t pos) noexcept
+{
+    size_t shift = pos % 64;
+    // Shifting the next word by 1 then 63 - shift avoids an undefined
+    // shift by 64 when the value doesn't cross into it
+    return (words[pos / 64] >> shift)
+         | ((words[pos / 64 + 1] << 1) << (63 - shift));
+}
+
+/**
+ * Unpacks n values of W bits each from words. W is a template parameter so
+ * that the shifts and masks are constants and the loop can be unrolled and
+ * vectorized, unpack picks the instantiation matching a width only known
+ * at runtime by walking down from the widest.
+ *
+ * Values are unpacked 8 at a time, so out must have room for n rounded up
+ * to a multiple of 8. This is the portable path, decode_block uses
+ * decode_avx2 instead for narrow 32 bit values when the cpu allows.
+ */
+template<typename U, size_t W> struct bit_unpacker
+{
+    static void unpack(size_t bits, const uint64_t * words, U * out,
+            size_t n) noexcept
+    {
+        if (bits != W)
+        {
+            bit_unpacker<U, W - 1>::unpack(bits, words, out, n);
+            return;
+        }
+
+        constexpr uint64_t mask = W == 64 ? ~(uint64_t)0 : ((uint64_t)1 << W) - 1;
+        const unsigned char * bytes = (const unsigned char *)words;
+        for (size_t i = 0; i < n; i += 8)
+        {
+            // 8 values take exactly W bytes, so every group starts on a
+            // byte boundary and the offsets within it are constants
+            const unsigned char * group = bytes + i * W / 8;
+            for (size_t j = 0; j < 8; j++)
+            {
+                uint64_t x;
+                if (W <= 56)
+                {
+                    // One unaligned load holds the whole value
+                    std::memcpy(&x, group + j * W / 8, 8);
+                    x >>= (j * W) % 8;
+                }
+                else
+                {
+                    x = bit_extract(words, (i + j) * W);
+                }
+                out[i + j] = (U)(x & mask);
+            }
+        }
+    }
+};
+
+template<typename U> struct bit_unpacker<U, 0>
+{
+    static void unpack(size_t, const uint64_t *, U * out, size_t n) noexcept
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            out[i] = 0;
+        }
+    }
+};
+
+#ifdef SL_PACKED_VECTOR_AVX2
+/**
+ * Check whether the running cpu supports AVX2
+ */
+inline bool cpu_has_avx2(void) noexcept
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+/**
+ * Decode n values of bits bits each from words into out with AVX2, n a
+ * multiple of 8. If delta is set the values are differences which are
+ * summed onto base, otherwise they are offsets from base.
+ *
+ * Each 128 bit lane unpacks 4 values with a byte shuffle, a per value
+ * shift and a mask, so a value and its shift have to fit in 32 bits and
+ * bits can be at most 25. Up to 16 bytes past the packed data are read.
+ */
+__attribute__((target("avx2")))
+inline void decode_avx2(size_t bits, const uint64_t * words, uint32_t * out,
+        size_t n, bool delta, uint32_t base) noexcept
+{
+    // The high lane is loaded from the byte holding the start of value 4,
+    // which keeps the last byte either lane needs below 16
+    size_t high_offset = bits * 4 / 8;
+    int lane_start = (int)(high_offset * 8);
+
+    // Bit position of each value within its lane, the byte it starts in
+    // becomes the shuffle control for all four of its bytes
+    const __m256i pos = _mm256_sub_epi32(
+            _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                _mm256_set1_epi32((int)bits)),
+            _mm256_setr_epi32(0, 0, 0, 0, lane_start, lane_start,
+                lane_start, lane_start));
+    const __m256i ctrl = _mm256_add_epi32(
+            _mm256_mullo_epi32(_mm256_srli_epi32(pos, 3),
+                _mm256_set1_epi32(0x01010101)),
+            _mm256_set1_epi32(0x03020100));
+    const __m256i counts = _mm256_and_si256(pos, _mm256_set1_epi32(7));
+    const __m256i mask = _mm256_set1_epi32((int)(((uint32_t)1 << bits) - 1));
+    const __m256i last = _mm256_set1_epi32(7);
+    __m256i acc = _mm256_set1_epi32((int)base);
+
+    const unsigned char * bytes = (const unsigned char *)words;
+    for (size_t i = 0; i < n; i += 8)
+    {
+        const unsigned char * group = bytes + i * bits / 8;
+        __m128i lo = _mm_loadu_si128((const __m128i *)group);
+        __m128i hi = _mm_loadu_si128((const __m128i *)(group + high_offset));
+        __m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        x = _mm256_shuffle_epi8(x, ctrl);
+        x = _mm256_and_si256(_mm256_srlv_epi32(x, counts), mask);
+        if (delta)
+        {
+            // Prefix sum within each lane, then carry the low lane's total
+            // into the high lane
+            x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+            x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+            __m256i t = _mm256_shuffle_epi32(x, 0xFF);
+            x = _mm256_add_epi32(x, _mm256_permute2x128_si256(t, t, 0x08));
+            // The last value is the running total for the next group
+            x = _mm256_add_epi32(x, acc);
+            acc = _mm256_permutevar8x32_epi32(x, last);
+        }
+        else
+        {
+            x = _mm256_add_epi32(x, acc);
+        }
+        _mm256_storeu_si256((__m256i *)(out + i), x);
+    }
+}
+#endif
+
+/**
+ * A vector of integers stored in fixed size blocks of BLOCK_SIZE values.
+ * Each full block is bit-packed, either as offsets from the block minimum
+ * (frame of reference) or as differences from the previous value (delta),
+ * whichever takes fewer bits. Sorted data packs very well with deltas, and
+ * clustered data packs well with frame of reference.
+ *
+ * Every block records its min and max, so searches and range scans can
+ * skip whole blocks without decoding them.
+ *
+ * Appended values are kept uncompressed in a tail block until it fills.
+ * The vector is append only, elements are read by value.
+ */
+template<typename T> class packed_vector {
+    static_assert(std::is_integral<T>::value,
+            "packed_vector only holds integers");
+
+    typedef typename std::make_unsigned<T>::type U;
+
+    public:
+        constexpr static size_t BLOCK_SIZE = 128;
+
+    protected:
+        /**
+         * Description of one packed block. Values are packed starting at
+         * bit 0 of m_words[offset], bits bits each.
+         */
+        struct block_header
+        {
+            T base;
+            T min;
+            T max;
+            size_t offset;
+            uint8_t bits;
+            bool delta;
+        };
+
+        stll::vector<block_header> m_blocks;
+        // Always holds two zero words past the packed data, so unpacking can
+        // read the next word unconditionally and decode_avx2 can overread
+        stll::vector<uint64_t> m_words;
+        T m_tail[BLOCK_SIZE];
+        size_t m_tail_size = 0;
+
+        /**
+         * Pack the full tail block and start a new one
+         */
+        void flush_tail(void);
+
+        /**
+         * Get the value packed at index i of the block starting at words
+         */
+        static U unpack_one(const uint64_t * words, size_t bits, size_t i) noexcept;
+
+    public:
+        /**
+         * Iterates over the values of a packed_vector, decoding a whole
+         * block at a time into a buffer.
+         */
+        class const_iterator
+        {
+            protected:
+                const packed_vector<T> * m_vector;
+                size_t m_index;
+                T m_buffer[BLOCK_SIZE];
+
+            public:
+                // Dereferencing returns a reference into this iterator's
+                // buffer, which only a single pass input iterator allows
+                typedef std::input_iterator_tag iterator_category;
+                typedef T value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const T * pointer;
+                typedef const T & reference;
+
+                const_iterator(const packed_vector<T> * v, size_t index);
+
+                const T & operator*(void) const noexcept;
+
+                const_iterator & operator++(void);
+
+                bool operator==(const const_iterator & other) const noexcept;
+
+                bool operator!=(const const_iterator & other) const noexcept;
+        };
+
+        /**
+         * Use a default constructor
+         */
+        packed_vector(void);
+
+        /**
+         * Append a value to the end of the vector
+         */
+        void emplace_back(T value);
+
+        /**
+         * Append the values between b and e
+         */
+        template<class InputIterator>
+        void append(InputIterator b, InputIterator e);
+
+        /**
+         * Get the value stored at the provided index. This decodes a single
+         * value, so prefer iterating or decode_block for scans.
+         */
+        T operator [](size_t index) const noexcept;
+
+        /**
+         * Get the index of the first value which is not less than value,
+         * or size() if there is none. The vector must be sorted. Blocks
+         * are found with their max value, so only one block is decoded.
+         */
+        size_t lower_bound(T value) const noexcept;
+
+        /**
+         * Decode all of the values of block b into out, which must have
+         * room for BLOCK_SIZE values. Returns the number of values written.
+         * The tail block is number block_count() - 1 if it isn't empty.
+         */
+        size_t decode_block(size_t b, T * out) const noexcept;
+
+        /**
+         * Get the number of blocks, including a partially filled tail block
+         */
+        size_t block_count(void) const noexcept;
+
+        /**
+         * Get the smallest value in block b
+         */
+        T block_min(size_t b) const noexcept;
+
+        /**
+         * Get the largest value in block b
+         */
+        T block_max(size_t b) const noexcept;
+
+        const_iterator begin(void) const;
+
+        const_iterator end(void) const;
+
+        size_t size(void) const noexcept;
+
+        bool empty(void) const noexcept;
+
+        /**
+         * Release the capacity the packed words and block headers have
+         * grown past their contents
+         */
+        void shrink_to_fit(void);
+
+        /**
+         * Get the number of bytes allocated to store the values, including
+         * the block headers, unused capacity and the uncompressed tail.
+         */
+        size_t memory_usage(void) const noexcept;
+};
+
+template<typename T>
+packed_vector<T>::packed_vector(void)
+{
+    this->m_words.emplace_back((uint64_t)0);
+    this->m_words.emplace_back((uint64_t)0);
+}
+
+template<typename T>
+void packed_vector<T>::emplace_back(T value)
+{
+    this->m_tail[this->m_tail_size] = value;
+    this->m_tail_size ++;
+    if (this->m_tail_size == BLOCK_SIZE)
+    {
+        this->flush_tail();
+    }
+}
+
+template<typename T>
+template<class InputIterator>
+void packed_vector<T>::append(InputIterator b, InputIterator e)
+{
+    for (; b != e; ++b)
+    {
+        this->emplace_back(*b);
+    }
+}
+
+template<typename T>
+void packed_vector<T>::flush_tail(void)
+{
+    const T * v = this->m_tail;
+
+    T min = v[0];
+    T max = v[0];
+    U max_delta = 0;
+    for (size_t i = 1; i < BLOCK_SIZE; i++)
+    {
+        if (v[i] < min) min = v[i];
+        if (v[i] > max) max = v[i];
+        U d = (U)((U)v[i] - (U)v[i - 1]);
+        if (d > max_delta) max_delta = d;
+    }
+
+    auto width = [](U x) -> uint8_t {
+        return x == 0 ? 0 : 64 - __builtin_clzll((unsigned long long)x);
+    };
+    uint8_t for_bits = width((U)max - (U)min);
+    uint8_t delta_bits = width(max_delta);
+
+    block_header h;
+    h.base = v[0];
+    h.min = min;
+    h.max = max;
+    h.delta = delta_bits < for_bits;
+    h.bits = h.delta ? delta_bits : for_bits;
+    // Reuse the trailing zero words as the first words of this block
+    h.offset = this->m_words.size() - 2;
+
+    size_t n_words = (BLOCK_SIZE * h.bits + 63) / 64;
+    for (size_t i = 0; i < n_words; i++)
+    {
+        this->m_words.emplace_back((uint64_t)0);
+    }
+
+    uint64_t * words = this->m_words.begin() + h.offset;
+    for (size_t i = 0; i < BLOCK_SIZE; i++)
+    {
+        U x = h.delta ? (U)(i == 0 ? 0 : (U)v[i] - (U)v[i - 1])
+                      : (U)((U)v[i] - (U)min);
+        size_t pos = i * h.bits;
+        size_t shift = pos % 64;
+        words[pos / 64] |= (uint64_t)x << shift;
+        if (shift + h.bits > 64)
+        {
+            words[pos / 64 + 1] |= (uint64_t)x >> (64 - shift);
+        }
+    }
+
+    this->m_blocks.emplace_back(h);
+    this->m_tail_size = 0;
+}
+
+template<typename T>
+typename packed_vector<T>::U packed_vector<T>::unpack_one(const uint64_t * words,
+        size_t bits, size_t i) noexcept
+{
+    // Constant blocks have no packed words of their own
+    if (bits == 0) return 0;
+
+    uint64_t x = bit_extract(words, i * bits);
+    uint64_t mask = bits == 64 ? ~(uint64_t)0 : ((uint64_t)1 << bits) - 1;
+    return (U)(x & mask);
+}
+
+template<typename T>
+size_t packed_vector<T>::decode_block(size_t b, T * out) const noexcept
+{
+    if (b == this->m_blocks.size())
+    {
+        for (size_t i = 0; i < this->m_tail_size; i++)
+        {
+            out[i] = this->m_tail[i];
+        }
+        return this->m_tail_size;
+    }
+
+    // Copy the header, stores through u could otherwise alias it
+    const block_header h = this->m_blocks[b];
+    U * u = (U *)out;
+
+#ifdef SL_PACKED_VECTOR_AVX2
+    if (sizeof(U) == 4 && h.bits <= 25 && cpu_has_avx2())
+    {
+        decode_avx2(h.bits, this->m_words.begin() + h.offset, (uint32_t *)u,
+                BLOCK_SIZE, h.delta, (uint32_t)(h.delta ? h.base : h.min));
+        return BLOCK_SIZE;
+    }
+#endif
+
+    bit_unpacker<U, sizeof(U) * 8>::unpack(h.bits,
+            this->m_words.begin() + h.offset, u, BLOCK_SIZE);
+
+    if (h.delta)
+    {
+        // Sum 4 deltas at a time off the running total, so the chain of
+        // dependent adds is a quarter as long as the block
+        U acc = (U)h.base;
+        for (size_t i = 0; i < BLOCK_SIZE; i += 4)
+        {
+            U s1 = u[i];
+            U s2 = s1 + u[i + 1];
+            U s3 = s2 + u[i + 2];
+            U s4 = s3 + u[i + 3];
+            u[i] = acc + s1;
+            u[i + 1] = acc + s2;
+            u[i + 2] = acc + s3;
+            u[i + 3] = acc + s4;
+            acc += s4;
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < BLOCK_SIZE; i++)
+        {
+            u[i] += (U)h.min;
+        }
+    }
+    return BLOCK_SIZE;
+}
+
+template<typename T>
+T packed_vector<T>::operator [](size_t index) const noexcept
+{
+    size_t b = index / BLOCK_SIZE;
+    size_t i = index % BLOCK_SIZE;
+    if (b == this->m_blocks.size())
+    {
+        return this->m_tail[i];
+    }
+
+    const block_header & h = this->m_blocks[b];
+    const uint64_t * words = this->m_words.begin() + h.offset;
+    if (!h.delta)
+    {
+        return (T)((U)h.min + unpack_one(words, h.bits, i));
+    }
+
+    // Deltas have to be summed from the start of the block, unpack them
+    // all at once rather than one at a time
+    U deltas[BLOCK_SIZE];
+    bit_unpacker<U, sizeof(U) * 8>::unpack(h.bits, words, deltas, i + 1);
+    U acc = (U)h.base;
+    for (size_t j = 1; j <= i; j++)
+    {
+        acc += deltas[j];
+    }
+    return (T)acc;
+}
+
+template<typename T>
+size_t packed_vector<T>::lower_bound(T value) const noexcept
+{
+    // Find the first block whose max is not less than value
+    size_t lo = 0;
+    size_t hi = this->block_count();
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (this->block_max(mid) < value)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if (lo == this->block_count()) return this->size();
+
+    T buffer[BLOCK_SIZE];
+    size_t n = this->decode_block(lo, buffer);
+    size_t i = 0;
+    while (i < n && buffer[i] < value)
+    {
+        i++;
+    }
+    return lo * BLOCK_SIZE + i;
+}
+
+template<typename T>
+size_t packed_vector<T>::block_count(void) const noexcept
+{
+    return this->m_blocks.size() + (this->m_tail_size > 0 ? 1 : 0);
+}
+
+template<typename T>
+T packed_vector<T>::block_min(size_t b) const noexcept
+{
+    if (b < this->m_blocks.size()) return this->m_blocks[b].min;
+
+    T min = this->m_tail[0];
+    for (size_t i = 1; i < this->m_tail_size; i++)
+    {
+        if (this->m_tail[i] < min) min = this->m_tail[i];
+    }
+    return min;
+}
+
+template<typename T>
+T packed_vector<T>::block_max(size_t b) const noexcept
+{
+    if (b < this->m_blocks.size()) return this->m_blocks[b].max;
+
+    T max = this->m_tail[0];
+    for (size_t i = 1; i < this->m_tail_size; i++)
+    {
+        if (this->m_tail[i] > max) max = this->m_tail[i];
+    }
+    return max;
+}
+
+template<typename T>
+typename packed_vector<T>::const_iterator packed_vector<T>::begin(void) const
+{
+    return const_iterator(this, 0);
+}
+
+template<typename T>
+typename packed_vector<T>::const_iterator packed_vector<T>::end(void) const
+{
+    return const_iterator(this, this->size());
+}
+
+template<typename T>
+size_t packed_vector<T>::size(void) const noexcept
+{
+    return this->m_blocks.size() * BLOCK_SIZE + this->m_tail_size;
+}
+
+template<typename T>
+bool packed_vector<T>::empty(void) const noexcept
+{
+    return this->size() == 0;
+}
+
+template<typename T>
+void packed_vector<T>::shrink_to_fit(void)
+{
+    this->m_blocks.shrink_to_fit();
+    this->m_words.shrink_to_fit();
+}
+
+template<typename T>
+size_t packed_vector<T>::memory_usage(void) const noexcept
+{
+    return this->m_blocks.capacity() * sizeof(block_header)
+         + this->m_words.capacity() * sizeof(uint64_t)
+         + sizeof(this->m_tail);
+}
+
+template<typename T>
+packed_vector<T>::const_iterator::const_iterator(const packed_vector<T> * v,
+        size_t index) : m_vector(v), m_index(index)
+{
+    if (this->m_index < this->m_vector->size())
+    {
+        this->m_vector->decode_block(this->m_index / BLOCK_SIZE, this->m_buffer);
+    }
+}
+
+template<typename T>
+const T & packed_vector<T>::const_iterator::operator*(void) const noexcept
+{
+    return this->m_buffer[this->m_index % BLOCK_SIZE];
+}
+
+template<typename T>
+typename packed_vector<T>::const_iterator &
+packed_vector<T>::const_iterator::operator++(void)
+{
+    this->m_index ++;
+    if (this->m_index % BLOCK_SIZE == 0 && this->m_index < this->m_vector->size())
+    {
+        this->m_vector->decode_block(this->m_index / BLOCK_SIZE, this->m_buffer);
+    }
+    return *this;
+}
+
+template<typename T>
+bool packed_vector<T>::const_iterator::operator==(
+        const const_iterator & other) const noexcept
+{
+    return this->m_index == other.m_index;
+}
+
+template<typename T>
+bool packed_vector<T>::const_iterator::operator!=(
+        const const_iterator & other) const noexcept
+{
+    return this->m_index != other.m_index;
+}
+
+}
+
+#endif
@@ -0,0 +1,308 @@
+/*
+ * Experimentation with cache friendly search structures over sorted data,
+ * using the STL library for comparison
+ */
+#ifndef SL_SEARCH_HPP
+#define SL_SEARCH_HPP
+
+#include <cstdint>
+#include <functional>
+#include <iterator>
+
+#include "sl-vector.hpp"
+
+namespace sll
+{
+/**
+ * A read-only search index over a sorted range. The elements are copied
+ * out of the sorted range and stored in Eytzinger (breadth first) order,
+ * so that the nodes visited by a binary search are packed together at the
+ * front of the array and the children of a node are adjacent in memory.
+ *
+ * Using one based indexing, the node at index k has children at 2k and
+ * 2k + 1, so the descendants of k four levels down (for 4 byte T) are the
+ * 16 nodes from 16k. The tree is placed so that node 0 starts a cache line,
+ * which puts those descendants in a single line and lets us prefetch them
+ * well before they are needed.
+ *
+ * The search itself is branchless, so the processor never mispredicts on
+ * the comparison, and the only stalls are for memory.
+ *
+ * Positions returned by the index are ranks in the original sorted range,
+ * as if by std::distance(start, std::lower_bound(start, end, x, c)). They
+ * are computed from the tree index rather than stored, so the index takes
+ * no more memory than the range itself.
+ */
+template <typename T, class Compare = std::less<T>>
+class static_search_index
+{
+    protected:
+        /**
+         * Number of queries the batched lookup keeps in flight at once.
+         */
+        constexpr static size_t BATCH_SIZE = 16;
+
+        constexpr static size_t CACHE_LINE_SIZE = 64;
+
+        /**
+         * How far ahead (in multiples of the current index) to prefetch.
+         * With one based indexing the node 2^l * k is the leftmost
+         * descendant of k, l levels down, so prefetching at
+         * PREFETCH_STRIDE * k pulls in the cache line holding all of the
+         * descendants at that level.
+         */
+        constexpr static size_t PREFETCH_STRIDE =
+            CACHE_LINE_SIZE / sizeof(T) > 0 ? CACHE_LINE_SIZE / sizeof(T) : 1;
+
+        // The tree starts m_offset elements into m_data, which puts node 0
+        // on a cache line boundary whenever sizeof(T) divides the line size.
+        // Node 0 is unused so that the children of k are 2k and 2k + 1
+        stll::vector<T> m_data;
+        size_t m_offset = 0;
+        size_t m_size = 0;
+        // Number of levels which are completely filled in the tree
+        size_t m_full_levels = 0;
+        Compare m_compare;
+
+        template <class RandomAccessIterator>
+        void build(RandomAccessIterator start, size_t & next, size_t k);
+
+        /**
+         * Get the tree, node k is nodes()[k]
+         */
+        const T * nodes(void) const noexcept;
+
+        /**
+         * Get the rank in the sorted range of node k, or size() for node 0
+         */
+        size_t rank(size_t k) const noexcept;
+
+        /**
+         * Descend one level from node k towards x
+         */
+        size_t step(size_t k, const T & x) const noexcept;
+
+        /**
+         * Finish a search which has descended through the full levels to k,
+         * returning the tree index of the lower bound, or 0 if there
+         * is none.
+         */
+        size_t finish(size_t k, const T & x) const noexcept;
+
+        /**
+         * Get the tree index of the lower bound of x, or 0 if there
+         * is none.
+         */
+        size_t search(const T & x) const noexcept;
+
+    public:
+        /**
+         * Create an index over the elements between start and end, which
+         * must already be sorted according to c.
+         */
+        template <class RandomAccessIterator>
+        static_search_index(RandomAccessIterator start,
+                RandomAccessIterator end, Compare c = Compare());
+
+        /**
+         * A copy would have its own alignment, so indexes can only be moved
+         */
+        static_search_index(const static_search_index & other) = delete;
+
+        static_search_index(static_search_index && other) = default;
+
+        static_search_index & operator=(const static_search_index & other) = delete;
+
+        static_search_index & operator=(static_search_index && other) = default;
+
+        /**
+         * Get the rank of the first element e in the indexed range for which
+         * c(e, x) == false, or size() if there is no such element.
+         */
+        size_t lower_bound(const T & x) const noexcept;
+
+        /**
+         * Test if an element equivalent to x is in the indexed range
+         */
+        bool contains(const T & x) const noexcept;
+
+        /**
+         * Look up count queries at once, writing the lower bound rank of
+         * queries[i] to out[i]. The queries are descended in lockstep so
+         * that the memory accesses for up to BATCH_SIZE of them overlap.
+         */
+        void lower_bound(const T * queries, size_t count, size_t * out) const noexcept;
+
+        /**
+         * Get the number of elements in the index
+         */
+        size_t size(void) const noexcept;
+};
+
+template <typename T, class Compare>
+template <class RandomAccessIterator>
+static_search_index<T, Compare>::static_search_index(RandomAccessIterator start,
+        RandomAccessIterator end, Compare c) : m_compare(c)
+{
+    this->m_size = std::distance(start, end);
+    // Leave room to shift the tree onto a cache line
+    this->m_data.ensure_capacity(this->m_size + PREFETCH_STRIDE);
+
+    size_t misalignment = (uintptr_t)this->m_data.begin() % CACHE_LINE_SIZE;
+    if (CACHE_LINE_SIZE % sizeof(T) == 0 && misalignment % sizeof(T) == 0)
+    {
+        this->m_offset = (CACHE_LINE_SIZE - misalignment) % CACHE_LINE_SIZE
+                       / sizeof(T);
+    }
+
+    // Fill with placeholders so that build can write by index
+    T placeholder = this->m_size > 0 ? *start : T();
+    for (size_t i = 0; i <= this->m_offset + this->m_size; i++)
+    {
+        this->m_data.emplace_back(placeholder);
+    }
+
+    size_t next = 0;
+    build(start, next, 1);
+
+    // Levels 0 .. m_full_levels - 1 hold 2^m_full_levels - 1 nodes
+    while (((size_t)2 << this->m_full_levels) - 1 <= this->m_size)
+    {
+        this->m_full_levels ++;
+    }
+}
+
+/**
+ * Fill the tree with an in-order traversal, so that the nodes come out of
+ * the sorted range in sorted order.
+ */
+template <typename T, class Compare>
+template <class RandomAccessIterator>
+void static_search_index<T, Compare>::build(RandomAccessIterator start,
+        size_t & next, size_t k)
+{
+    if (k > this->m_size) return;
+
+    build(start, next, 2 * k);
+    this->m_data[this->m_offset + k] = *(start + next);
+    next ++;
+    build(start, next, 2 * k + 1);
+}
+
+template <typename T, class Compare>
+const T * static_search_index<T, Compare>::nodes(void) const noexcept
+{
+    return this->m_data.begin() + this->m_offset;
+}
+
+/**
+ * Node k at depth d would have in-order position
+ * (2k + 1) * 2^(m_full_levels - d) - 2^(m_full_levels + 1) - 1
+ * if the partially filled bottom level were full. The missing bottom nodes
+ * are the ones at the even positions from twice the number present, so
+ * every position past that has half of the gap taken away.
+ */
+template <typename T, class Compare>
+size_t static_search_index<T, Compare>::rank(size_t k) const noexcept
+{
+    if (k == 0) return this->m_size;
+
+    size_t depth = 63 - __builtin_clzll(k);
+    size_t position = ((2 * k + 1) << (this->m_full_levels - depth))
+                    - ((size_t)2 << this->m_full_levels) - 1;
+    size_t bottom = 2 * (this->m_size + 1 - ((size_t)1 << this->m_full_levels));
+    return position < bottom ? position : (position + bottom - 1) / 2;
+}
+
+template <typename T, class Compare>
+size_t static_search_index<T, Compare>::step(size_t k, const T & x) const noexcept
+{
+    const T * nodes = this->nodes();
+    __builtin_prefetch(nodes + PREFETCH_STRIDE * k);
+    return 2 * k + this->m_compare(nodes[k], x);
+}
+
+template <typename T, class Compare>
+size_t static_search_index<T, Compare>::finish(size_t k, const T & x) const noexcept
+{
+    // The bottom level may be partially filled, the conditional here
+    // compiles to a cmov rather than a branch
+    size_t in_tree = k <= this->m_size;
+    size_t last = in_tree ? k : 0;
+    k = in_tree ? 2 * k + this->m_compare(this->nodes()[last], x) : k;
+
+    // Every right turn appends a 1 bit to k, and the lower bound is the
+    // last node where we turned left, so strip the trailing ones and the
+    // final zero.
+    k >>= __builtin_ffsll(~k);
+    return k;
+}
+
+template <typename T, class Compare>
+size_t static_search_index<T, Compare>::search(const T & x) const noexcept
+{
+    size_t k = 1;
+    for (size_t level = 0; level < this->m_full_levels; level++)
+    {
+        k = step(k, x);
+    }
+    return finish(k, x);
+}
+
+template <typename T, class Compare>
+size_t static_search_index<T, Compare>::lower_bound(const T & x) const noexcept
+{
+    return rank(search(x));
+}
+
+template <typename T, class Compare>
+bool static_search_index<T, Compare>::contains(const T & x) const noexcept
+{
+    // The lower bound e already satisfies !c(e, x), so it is equivalent
+    // to x exactly when !c(x, e)
+    size_t k = search(x);
+    return k != 0 && !this->m_compare(x, this->nodes()[k]);
+}
+
+template <typename T, class Compare>
+void static_search_index<T, Compare>::lower_bound(const T * queries,
+        size_t count, size_t * out) const noexcept
+{
+    size_t k[BATCH_SIZE];
+    size_t i = 0;
+
+    for (; i + BATCH_SIZE <= count; i += BATCH_SIZE)
+    {
+        for (size_t j = 0; j < BATCH_SIZE; j++)
+        {
+            k[j] = 1;
+        }
+        // Every query takes the same number of full levels, so walking them
+        // level by level keeps BATCH_SIZE independent loads in flight.
+        for (size_t level = 0; level < this->m_full_levels; level++)
+        {
+            for (size_t j = 0; j < BATCH_SIZE; j++)
+            {
+                k[j] = step(k[j], queries[i + j]);
+            }
+        }
+        for (size_t j = 0; j < BATCH_SIZE; j++)
+        {
+            out[i + j] = rank(finish(k[j], queries[i + j]));
+        }
+    }
+
+    for (; i < count; i++)
+    {
+        out[i] = lower_bound(queries[i]);
+    }
+}
+
+template <typename T, class Compare>
+size_t static_search_index<T, Compare>::size(void) const noexcept
+{
+    return this->m_size;
+}
+}
+
+#endif
@@ -0,0 +1,425 @@
+/*
+ * Experimentation with cheaply shared, copy on write vectors
+ */
+#ifndef SL_SHARED_VECTOR_HPP
+#define SL_SHARED_VECTOR_HPP
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "sl-vector.hpp"
+
+// STL learning namespace
+namespace stll
+{
+
+/**
+ * A vector whose contents are shared between copies. Copying only bumps an
+ * atomic reference count, so handing a snapshot to another thread is O(1).
+ * The contents are copied the first time a copy is modified while it is
+ * still shared (copy on write), so every copy behaves like an independent
+ * vector.
+ *
+ * A single shared_vector must not be used from several threads at once, but
+ * separate copies of the same contents can be.
+ */
+template<typename T> class shared_vector {
+    protected:
+        struct shared_buffer
+        {
+            std::atomic<size_t> refs;
+            stll::vector<T> data;
+
+            shared_buffer(void) : refs(1) {}
+            shared_buffer(const stll::vector<T> & other) : refs(1), data(other) {}
+            shared_buffer(stll::vector<T> && other) : refs(1), data(std::move(other)) {}
+        };
+
+        shared_buffer * m_buffer = nullptr;
+
+        /**
+         * Drop this copy's reference to the buffer, deleting it if this was
+         * the last one.
+         */
+        void release(void) noexcept;
+
+        /**
+         * Make sure this copy is the only one referencing its buffer, so
+         * that it can be modified.
+         */
+        void detach(void);
+
+        template<typename U> friend class published_vector;
+
+    public:
+        /**
+         * Use a default constructor
+         */
+        shared_vector(void) = default;
+
+        /**
+         * Create a shared vector holding a copy of other
+         */
+        explicit shared_vector(const stll::vector<T> & other);
+
+        /**
+         * Create a shared vector taking over the contents of other
+         */
+        explicit shared_vector(stll::vector<T> && other);
+
+        /**
+         * Copy constructor, this shares the contents with other
+         */
+        shared_vector(const shared_vector<T> & other) noexcept;
+
+        /**
+         * Move constructor
+         */
+        shared_vector(shared_vector<T> && other) noexcept;
+
+        /**
+         * Copy assignment operator, this shares the contents with other
+         */
+        shared_vector<T> & operator=(const shared_vector<T> & other) noexcept;
+
+        /**
+         * Move assignment operator
+         */
+        shared_vector<T> & operator=(shared_vector<T> && other) noexcept;
+
+        /**
+         * Drop the reference to the contents
+         */
+        ~shared_vector();
+
+        /**
+         * Read the element stored at the provided index
+         */
+        const T & operator [](size_t index) const noexcept;
+
+        /**
+         * Replace the element stored at the provided index
+         */
+        void set(size_t index, const T & val);
+
+        /**
+         * Construct a new element T with the provided arguments
+         */
+        template<class ...Args> void emplace_back(Args&&... args);
+
+        /**
+         * Delete the last element in the vector
+         */
+        void pop_back(void);
+
+        /**
+         * Get the underlying vector for a batch of modifications. The
+         * reference is only valid until this shared_vector is next copied.
+         */
+        stll::vector<T> & mutate(void);
+
+        const T * begin(void) const noexcept;
+
+        const T * end(void) const noexcept;
+
+        size_t size(void) const noexcept;
+
+        bool empty(void) const noexcept;
+
+        /**
+         * Get the number of copies sharing these contents
+         */
+        size_t use_count(void) const noexcept;
+};
+
+/**
+ * A slot holding the current version of a shared_vector, which many reader
+ * threads can take snapshots of while writers publish new versions, in the
+ * style of read-copy-update (RCU).
+ *
+ * Readers never block, taking a snapshot is a handful of atomic operations.
+ * A writer swaps in the new version, then waits for any reader which might
+ * have seen the old pointer to finish taking its reference before dropping
+ * its own. Writers are serialized with each other by a mutex.
+ */
+template<typename T> class published_vector {
+    typedef typename shared_vector<T>::shared_buffer shared_buffer;
+
+    protected:
+        std::atomic<shared_buffer *> m_current;
+        // Readers register in the counter for the current epoch while they
+        // take a reference. A writer flips the epoch then waits for the old
+        // counter to drain, so a steady stream of readers can't starve it.
+        std::atomic<size_t> m_epoch;
+        mutable std::atomic<size_t> m_readers[2];
+        std::mutex m_write_mutex;
+        // Held across a whole update, so updates see each other's changes
+        std::mutex m_update_mutex;
+
+    public:
+        /**
+         * Create a slot holding version
+         */
+        explicit published_vector(shared_vector<T> version = shared_vector<T>());
+
+        published_vector(const published_vector<T> & other) = delete;
+
+        published_vector<T> & operator=(const published_vector<T> & other) = delete;
+
+        ~published_vector();
+
+        /**
+         * Take a snapshot of the current version
+         */
+        shared_vector<T> load(void) const noexcept;
+
+        /**
+         * Replace the current version. Readers holding snapshots of the old
+         * version keep it alive until they drop them.
+         */
+        void publish(shared_vector<T> version);
+
+        /**
+         * Copy the current version, apply f to the copy's stll::vector, and
+         * publish the result. Concurrent updates are applied one at a time.
+         */
+        template<class Function> void update(Function f);
+};
+
+template<typename T>
+shared_vector<T>::shared_vector(const stll::vector<T> & other) :
+    m_buffer{new shared_buffer(other)}
+{
+}
+
+template<typename T>
+shared_vector<T>::shared_vector(stll::vector<T> && other) :
+    m_buffer{new shared_buffer(std::move(other))}
+{
+}
+
+template<typename T>
+shared_vector<T>::shared_vector(const shared_vector<T> & other) noexcept :
+    m_buffer{other.m_buffer}
+{
+    if (this->m_buffer != nullptr)
+    {
+        this->m_buffer->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+shared_vector<T>::shared_vector(shared_vector<T> && other) noexcept :
+    m_buffer{other.m_buffer}
+{
+    other.m_buffer = nullptr;
+}
+
+template<typename T>
+shared_vector<T> & shared_vector<T>::operator=(const shared_vector<T> & other) noexcept
+{
+    if (this->m_buffer == other.m_buffer) return *this;
+
+    this->release();
+    this->m_buffer = other.m_buffer;
+    if (this->m_buffer != nullptr)
+    {
+        this->m_buffer->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    return *this;
+}
+
+template<typename T>
+shared_vector<T> & shared_vector<T>::operator=(shared_vector<T> && other) noexcept
+{
+    if (this == &other) return *this;
+
+    this->release();
+    this->m_buffer = other.m_buffer;
+    other.m_buffer = nullptr;
+    return *this;
+}
+
+template<typename T>
+shared_vector<T>::~shared_vector()
+{
+    this->release();
+}
+
+template<typename T>
+void shared_vector<T>::release(void) noexcept
+{
+    // The last owner has to see every other owner's writes before deleting
+    if (this->m_buffer != nullptr
+            && this->m_buffer->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete this->m_buffer;
+    }
+    this->m_buffer = nullptr;
+}
+
+template<typename T>
+void shared_vector<T>::detach(void)
+{
+    if (this->m_buffer == nullptr)
+    {
+        this->m_buffer = new shared_buffer();
+    }
+    else if (this->m_buffer->refs.load(std::memory_order_acquire) != 1)
+    {
+        shared_buffer * copy = new shared_buffer(this->m_buffer->data);
+        this->release();
+        this->m_buffer = copy;
+    }
+}
+
+template<typename T>
+const T & shared_vector<T>::operator [](size_t index) const noexcept
+{
+    // Need to guard this in debug mode
+    return this->m_buffer->data[index];
+}
+
+template<typename T>
+void shared_vector<T>::set(size_t index, const T & val)
+{
+    this->detach();
+    this->m_buffer->data[index] = val;
+}
+
+template<typename T>
+template<class ...Args>
+void shared_vector<T>::emplace_back(Args&&... args)
+{
+    this->detach();
+    this->m_buffer->data.emplace_back(std::forward<Args>(args)...);
+}
+
+template<typename T>
+void shared_vector<T>::pop_back(void)
+{
+    this->detach();
+    this->m_buffer->data.pop_back();
+}
+
+template<typename T>
+stll::vector<T> & shared_vector<T>::mutate(void)
+{
+    this->detach();
+    return this->m_buffer->data;
+}
+
+template<typename T>
+const T * shared_vector<T>::begin(void) const noexcept
+{
+    return this->m_buffer == nullptr ? nullptr : this->m_buffer->data.begin();
+}
+
+template<typename T>
+const T * shared_vector<T>::end(void) const noexcept
+{
+    return this->m_buffer == nullptr ? nullptr : this->m_buffer->data.end();
+}
+
+template<typename T>
+size_t shared_vector<T>::size(void) const noexcept
+{
+    return this->m_buffer == nullptr ? 0 : this->m_buffer->data.size();
+}
+
+template<typename T>
+bool shared_vector<T>::empty(void) const noexcept
+{
+    return this->size() == 0;
+}
+
+template<typename T>
+size_t shared_vector<T>::use_count(void) const noexcept
+{
+    return this->m_buffer == nullptr
+        ? 0 : this->m_buffer->refs.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+published_vector<T>::published_vector(shared_vector<T> version) :
+    m_current{version.m_buffer}, m_epoch{0}
+{
+    // Take over the version's reference
+    version.m_buffer = nullptr;
+    this->m_readers[0] = 0;
+    this->m_readers[1] = 0;
+}
+
+template<typename T>
+published_vector<T>::~published_vector()
+{
+    shared_vector<T> last;
+    last.m_buffer = this->m_current.load();
+}
+
+template<typename T>
+shared_vector<T> published_vector<T>::load(void) const noexcept
+{
+    // Register as a reader before looking at the pointer, so a writer
+    // which swaps it out will wait for us to take our reference. If the
+    // epoch moved on while registering, a writer may already have checked
+    // our counter and left, so register again in the new epoch.
+    size_t epoch = this->m_epoch.load();
+    while (true)
+    {
+        this->m_readers[epoch & 1].fetch_add(1);
+        size_t current = this->m_epoch.load();
+        if (current == epoch) break;
+
+        this->m_readers[epoch & 1].fetch_sub(1);
+        epoch = current;
+    }
+    epoch &= 1;
+
+    shared_vector<T> snapshot;
+    snapshot.m_buffer = this->m_current.load();
+    if (snapshot.m_buffer != nullptr)
+    {
+        snapshot.m_buffer->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    this->m_readers[epoch].fetch_sub(1);
+    return snapshot;
+}
+
+template<typename T>
+void published_vector<T>::publish(shared_vector<T> version)
+{
+    std::lock_guard<std::mutex> lock(this->m_write_mutex);
+
+    shared_vector<T> old;
+    old.m_buffer = this->m_current.exchange(version.m_buffer);
+    version.m_buffer = nullptr;
+
+    // Readers which registered in the old epoch may still be about to take
+    // a reference to the old buffer. Readers in the new epoch can only see
+    // the new pointer.
+    size_t epoch = this->m_epoch.fetch_add(1) & 1;
+    while (this->m_readers[epoch].load() != 0)
+    {
+        std::this_thread::yield();
+    }
+    // old drops the slot's reference here
+}
+
+template<typename T>
+template<class Function>
+void published_vector<T>::update(Function f)
+{
+    std::lock_guard<std::mutex> lock(this->m_update_mutex);
+
+    shared_vector<T> version = this->load();
+    f(version.mutate());
+    this->publish(std::move(version));
+}
+
+}
+
+#endif
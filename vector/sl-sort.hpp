@@ -1,7 +1,18 @@
 /*
  * Experimentation with different sorting algorithms, using the STL library
  */
+#ifndef SL_SORT_HPP
+#define SL_SORT_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <utility>
+
+#include "sl-vector.hpp"
 
 namespace sll
 {
@@ -109,18 +120,143 @@ void heapify_end_pop(RandomAccessIterator start, RandomAccessIterator end, Compa
 template <class RandomAccessIterator, class Compare>
 void heapify_inplace_sort(RandomAccessIterator start, RandomAccessIterator end, Compare);
 
+/**
+ * Get the permutation which sorts the elements between start and end
+ * according to c, without moving any of them. Element i of the result is
+ * the index (relative to start) of the element which belongs at position i
+ * of the sorted range.
+ *
+ * Only the indices are swapped while sorting, so this is much cheaper than
+ * sorting wide records directly. Index can be uint64_t for ranges with more
+ * than 2^32 elements, the range must not have more elements than Index can
+ * count.
+ */
+template <class Index = uint32_t, class RandomAccessIterator, class Compare>
+stll::vector<Index> argsort(RandomAccessIterator start, RandomAccessIterator end,
+        Compare c);
+
+/**
+ * Get the sorting permutation according to the default less operator.
+ */
+template <class Index = uint32_t, class RandomAccessIterator>
+stll::vector<Index> argsort(RandomAccessIterator start, RandomAccessIterator end);
+
+/**
+ * Get the sorting permutation using a cached key prefix. prefix(e) must
+ * return a small, cheaply compared key such that
+ * prefix(e) < prefix(f) implies c(e, f), for example the first 8 bytes of a
+ * string key. The (prefix, index) pairs are sorted together, so most
+ * comparisons never touch the records, and c is only used to break ties
+ * between equal prefixes.
+ */
+template <class Index = uint32_t, class RandomAccessIterator, class Prefix,
+         class Compare>
+stll::vector<Index> argsort_by_prefix(RandomAccessIterator start,
+        RandomAccessIterator end, Prefix prefix, Compare c);
+
+/**
+ * Copy the perm.size() elements starting at start to out in the order given
+ * by the permutation perm, so that out[i] = start[perm[i]].
+ */
+template <class RandomAccessIterator, class OutputIterator, class Index>
+OutputIterator apply_permutation(RandomAccessIterator start,
+        const stll::vector<Index> & perm, OutputIterator out);
+
+/**
+ * Reorder the elements between start and end in place so that the element
+ * at position i is the one which was at start[perm[i]]. Each cycle of the
+ * permutation is followed once, so every element is moved exactly once
+ * with a single temporary per cycle.
+ */
+template <class RandomAccessIterator, class Index>
+void permute_inplace(RandomAccessIterator start, RandomAccessIterator end,
+        const stll::vector<Index> & perm);
+
+/**
+ * Sort a range of strings (anything with data() and size(), such as
+ * std::string or std::string_view) lexicographically, using multikey
+ * quicksort.
+ *
+ * Rather than comparing whole strings, the strings are partitioned three
+ * ways on an 8 byte chunk of characters at the current depth. The chunks
+ * are cached next to the string index, so partitioning never touches the
+ * strings themselves. Only the strings which share the pivot's chunk move
+ * on to the next 8 bytes, so each character is examined about once.
+ */
+template <class RandomAccessIterator>
+void string_sort(RandomAccessIterator start, RandomAccessIterator end);
+
+/**
+ * Sort a range of strings lexicographically using a merge sort which keeps
+ * track of the longest common prefix (LCP) of neighbouring strings. When
+ * merging, the LCP of each run's head with the last string written out
+ * decides most comparisons outright, and the rest start comparing after
+ * the shared prefix, so common prefixes are never scanned twice.
+ *
+ * This is stable, and works well for strings with long shared prefixes.
+ */
+template <class RandomAccessIterator>
+void string_merge_sort(RandomAccessIterator start, RandomAccessIterator end);
+
+/**
+ * An 8 byte chunk of a string, along with the index of the string it came
+ * from
+ */
+struct string_key
+{
+    uint64_t prefix;
+    size_t index;
+};
+
+/**
+ * Get the 8 characters of s starting at depth, packed big endian so that
+ * comparing the integers compares the characters. Characters past the end
+ * of the string are 0.
+ */
+template <class String>
+uint64_t string_prefix(const String & s, size_t depth);
+
+/**
+ * Compare a and b lexicographically, assuming the first depth characters
+ * are equal. Returns a negative number, 0, or a positive number as a is
+ * less than, equal to or greater than b, and sets lcp to the length of
+ * their common prefix.
+ */
+template <class String>
+int string_compare_from(const String & a, const String & b, size_t depth,
+        size_t & lcp);
+
+/**
+ * Multikey quicksort the n keys which share their first depth characters
+ */
+template <class RandomAccessIterator>
+void multikey_quicksort(RandomAccessIterator strings, string_key * keys,
+        size_t n, size_t depth);
+
+/**
+ * LCP merge sort the n string indices idx, filling lcp[i] with the LCP of
+ * the strings at idx[i - 1] and idx[i]. tmp_idx and tmp_lcp are scratch
+ * space of the same size.
+ */
+template <class RandomAccessIterator>
+void lcp_merge_sort(RandomAccessIterator strings, size_t * idx, size_t * lcp,
+        size_t * tmp_idx, size_t * tmp_lcp, size_t n);
+
 
 template <class RandomAccessIterator>
 void heap_sort(RandomAccessIterator start, RandomAccessIterator end)
 {
-    heap_sort(start, end, std::less<typename RandomAccessIterator::value_type>());
+    heap_sort(start, end,
+            std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>());
 }
 
 template <class RandomAccessIterator, class Compare>
 void heap_sort(RandomAccessIterator start, RandomAccessIterator end, Compare c)
 {
-    typedef typename RandomAccessIterator::value_type  T;
-    auto lambda_compare = [c](T t1, T t2) {return !c(t1, t2);};
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type  T;
+    // Take the arguments by reference, copying wide records on every
+    // comparison costs more than the comparison itself
+    auto lambda_compare = [c](const T & t1, const T & t2) {return !c(t1, t2);};
     heapify(start, end, lambda_compare);
     heapify_inplace_sort(start, end, lambda_compare);
 }
@@ -173,7 +309,7 @@ void heapify_down(RandomAccessIterator start, RandomAccessIterator end,
     if (min_child < end)
     {
         // if child < parent, swap them and check the child's children
-        if (min_child != cur)
+        if (c(*min_child, *cur))
         {
             std::iter_swap(min_child, cur);
             heapify_down(start, end, min_child, c);
@@ -210,4 +346,385 @@ void heapify_end_pop(RandomAccessIterator start, RandomAccessIterator end, Compa
     std::iter_swap(start, end - 1);
     heapify_down(start, end - 1, start, c);
 }
+
+template <class Index, class RandomAccessIterator, class Compare>
+stll::vector<Index> argsort(RandomAccessIterator start, RandomAccessIterator end,
+        Compare c)
+{
+    size_t n = std::distance(start, end);
+    // Indices past the range of Index would silently wrap
+    assert(n <= (size_t)std::numeric_limits<Index>::max());
+    stll::vector<Index> perm;
+    perm.ensure_capacity(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        perm.emplace_back((Index)i);
+    }
+
+    heap_sort(perm.begin(), perm.end(), [start, c](Index i, Index j) {
+        return c(start[i], start[j]);
+    });
+    return perm;
+}
+
+template <class Index, class RandomAccessIterator>
+stll::vector<Index> argsort(RandomAccessIterator start, RandomAccessIterator end)
+{
+    return argsort<Index>(start, end,
+            std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>());
+}
+
+template <class Index, class RandomAccessIterator, class Prefix, class Compare>
+stll::vector<Index> argsort_by_prefix(RandomAccessIterator start,
+        RandomAccessIterator end, Prefix prefix, Compare c)
+{
+    typedef decltype(prefix(*start)) Key;
+    typedef std::pair<Key, Index> KeyIndex;
+
+    size_t n = std::distance(start, end);
+    assert(n <= (size_t)std::numeric_limits<Index>::max());
+    stll::vector<KeyIndex> keys;
+    keys.ensure_capacity(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        keys.emplace_back(KeyIndex(prefix(start[i]), (Index)i));
+    }
+
+    heap_sort(keys.begin(), keys.end(), [start, c](const KeyIndex & a,
+                const KeyIndex & b) {
+        if (a.first < b.first) return true;
+        if (b.first < a.first) return false;
+        return c(start[a.second], start[b.second]);
+    });
+
+    stll::vector<Index> perm;
+    perm.ensure_capacity(n);
+    for (auto & k : keys)
+    {
+        perm.emplace_back(k.second);
+    }
+    return perm;
+}
+
+template <class RandomAccessIterator, class OutputIterator, class Index>
+OutputIterator apply_permutation(RandomAccessIterator start,
+        const stll::vector<Index> & perm, OutputIterator out)
+{
+    for (auto i : perm)
+    {
+        *out = start[i];
+        ++ out;
+    }
+    return out;
+}
+
+template <class RandomAccessIterator, class Index>
+void permute_inplace(RandomAccessIterator start, RandomAccessIterator end,
+        const stll::vector<Index> & perm)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type  T;
+    size_t n = std::distance(start, end);
+
+    stll::vector<bool> done;
+    done.ensure_capacity(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        done.emplace_back(false);
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (done[i]) continue;
+
+        // Walk the cycle through i, pulling each element into the hole left
+        // by the previous one, until we get back to i
+        T tmp = std::move(start[i]);
+        size_t j = i;
+        while ((size_t)perm[j] != i)
+        {
+            size_t k = perm[j];
+            start[j] = std::move(start[k]);
+            done[j] = true;
+            j = k;
+        }
+        start[j] = std::move(tmp);
+        done[j] = true;
+    }
+}
+
+template <class String>
+uint64_t string_prefix(const String & s, size_t depth)
+{
+    size_t n = s.size();
+    if (depth >= n) return 0;
+
+    const unsigned char * p = (const unsigned char *)s.data() + depth;
+    size_t remaining = n - depth;
+    if (remaining >= 8)
+    {
+        uint64_t chunk;
+        std::memcpy(&chunk, p, 8);
+        return __builtin_bswap64(chunk);
+    }
+
+    uint64_t chunk = 0;
+    for (size_t i = 0; i < remaining; i++)
+    {
+        chunk = (chunk << 8) | p[i];
+    }
+    return chunk << (8 * (8 - remaining));
+}
+
+template <class String>
+int string_compare_from(const String & a, const String & b, size_t depth,
+        size_t & lcp)
+{
+    const unsigned char * pa = (const unsigned char *)a.data();
+    const unsigned char * pb = (const unsigned char *)b.data();
+    size_t n = a.size() < b.size() ? a.size() : b.size();
+
+    size_t i = depth;
+    while (i < n && pa[i] == pb[i])
+    {
+        i++;
+    }
+    lcp = i;
+
+    if (i < n) return pa[i] < pb[i] ? -1 : 1;
+    if (a.size() == b.size()) return 0;
+    return a.size() < b.size() ? -1 : 1;
+}
+
+template <class RandomAccessIterator>
+void multikey_quicksort(RandomAccessIterator strings, string_key * keys,
+        size_t n, size_t depth)
+{
+    // Each pass splits the keys into three groups. The two smaller ones,
+    // which hold at most half the keys each, are sorted recursively and the
+    // largest one by the next pass, so the recursion depth is logarithmic
+    // however unbalanced the pivots or long the common prefixes are.
+    while (n >= 16)
+    {
+        // Median of three pivot
+        uint64_t a = keys[0].prefix;
+        uint64_t b = keys[n / 2].prefix;
+        uint64_t c = keys[n - 1].prefix;
+        uint64_t pivot = a < b ? (b < c ? b : (a < c ? c : a))
+                               : (a < c ? a : (b < c ? c : b));
+
+        // Three way partition, [0, lt) < pivot, [lt, i) == pivot,
+        // [gt, n) > pivot
+        size_t lt = 0;
+        size_t gt = n;
+        size_t i = 0;
+        while (i < gt)
+        {
+            if (keys[i].prefix < pivot)
+            {
+                std::swap(keys[lt], keys[i]);
+                lt++;
+                i++;
+            }
+            else if (keys[i].prefix > pivot)
+            {
+                gt--;
+                std::swap(keys[i], keys[gt]);
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        // Strings in the middle which end within this chunk are equal to
+        // each other apart from trailing zero padding, so the shorter ones
+        // are prefixes of the longer ones. They go first, ordered by
+        // length, and the rest carry on to the next chunk.
+        string_key * eq = keys + lt;
+        size_t n_eq = gt - lt;
+        size_t n_ended = 0;
+        for (size_t k = 0; k < n_eq; k++)
+        {
+            if (strings[eq[k].index].size() <= depth + 8)
+            {
+                std::swap(eq[n_ended], eq[k]);
+                n_ended++;
+            }
+        }
+        heap_sort(eq, eq + n_ended, [strings](const string_key & x,
+                    const string_key & y) {
+            return strings[x.index].size() < strings[y.index].size();
+        });
+
+        for (size_t k = n_ended; k < n_eq; k++)
+        {
+            eq[k].prefix = string_prefix(strings[eq[k].index], depth + 8);
+        }
+
+        string_key * part[3] = {keys, keys + gt, eq + n_ended};
+        size_t part_n[3] = {lt, n - gt, n_eq - n_ended};
+        size_t part_depth[3] = {depth, depth, depth + 8};
+        size_t largest = 0;
+        for (size_t k = 1; k < 3; k++)
+        {
+            if (part_n[k] > part_n[largest]) largest = k;
+        }
+        for (size_t k = 0; k < 3; k++)
+        {
+            if (k == largest) continue;
+            multikey_quicksort(strings, part[k], part_n[k], part_depth[k]);
+        }
+        keys = part[largest];
+        n = part_n[largest];
+        depth = part_depth[largest];
+    }
+
+    // Small groups are cheaper to insertion sort, using the cached prefix
+    // where it differs and comparing the rest of the strings otherwise
+    for (size_t i = 1; i < n; i++)
+    {
+        string_key cur = keys[i];
+        size_t j = i;
+        for (; j > 0; j--)
+        {
+            size_t lcp;
+            const string_key & prev = keys[j - 1];
+            if (prev.prefix < cur.prefix) break;
+            if (prev.prefix == cur.prefix
+                    && string_compare_from(strings[prev.index],
+                        strings[cur.index], depth, lcp) <= 0) break;
+            keys[j] = prev;
+        }
+        keys[j] = cur;
+    }
 }
+
+template <class RandomAccessIterator>
+void string_sort(RandomAccessIterator start, RandomAccessIterator end)
+{
+    size_t n = std::distance(start, end);
+    stll::vector<string_key> keys;
+    keys.ensure_capacity(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        string_key k = {string_prefix(start[i], 0), i};
+        keys.emplace_back(k);
+    }
+
+    multikey_quicksort(start, keys.begin(), n, 0);
+
+    stll::vector<size_t> perm;
+    perm.ensure_capacity(n);
+    for (auto & k : keys)
+    {
+        perm.emplace_back(k.index);
+    }
+    permute_inplace(start, end, perm);
+}
+
+template <class RandomAccessIterator>
+void lcp_merge_sort(RandomAccessIterator strings, size_t * idx, size_t * lcp,
+        size_t * tmp_idx, size_t * tmp_lcp, size_t n)
+{
+    if (n <= 1)
+    {
+        if (n == 1) lcp[0] = 0;
+        return;
+    }
+
+    size_t m = n / 2;
+    lcp_merge_sort(strings, idx, lcp, tmp_idx, tmp_lcp, m);
+    lcp_merge_sort(strings, idx + m, lcp + m, tmp_idx, tmp_lcp, n - m);
+
+    // ha and hb are the LCPs of the heads of each run with the last string
+    // written out. If they differ, the head with the longer LCP is smaller,
+    // otherwise compare the heads starting after the shared prefix.
+    size_t i = 0;
+    size_t j = m;
+    size_t k = 0;
+    size_t ha = 0;
+    size_t hb = 0;
+    while (i < m && j < n)
+    {
+        bool take_a;
+        if (ha != hb)
+        {
+            take_a = ha > hb;
+        }
+        else
+        {
+            size_t h;
+            take_a = string_compare_from(strings[idx[i]], strings[idx[j]],
+                    ha, h) <= 0;
+            // The loser now shares h characters with the string written out
+            if (take_a)
+            {
+                hb = h;
+            }
+            else
+            {
+                ha = h;
+            }
+        }
+
+        if (take_a)
+        {
+            tmp_idx[k] = idx[i];
+            tmp_lcp[k] = ha;
+            i++;
+            ha = i < m ? lcp[i] : 0;
+        }
+        else
+        {
+            tmp_idx[k] = idx[j];
+            tmp_lcp[k] = hb;
+            j++;
+            hb = j < n ? lcp[j] : 0;
+        }
+        k++;
+    }
+
+    for (; i < m; i++, k++)
+    {
+        tmp_idx[k] = idx[i];
+        tmp_lcp[k] = ha;
+        ha = i + 1 < m ? lcp[i + 1] : 0;
+    }
+    for (; j < n; j++, k++)
+    {
+        tmp_idx[k] = idx[j];
+        tmp_lcp[k] = hb;
+        hb = j + 1 < n ? lcp[j + 1] : 0;
+    }
+
+    std::memcpy(idx, tmp_idx, n * sizeof(size_t));
+    std::memcpy(lcp, tmp_lcp, n * sizeof(size_t));
+}
+
+template <class RandomAccessIterator>
+void string_merge_sort(RandomAccessIterator start, RandomAccessIterator end)
+{
+    size_t n = std::distance(start, end);
+    stll::vector<size_t> perm;
+    stll::vector<size_t> lcp;
+    stll::vector<size_t> tmp_idx;
+    stll::vector<size_t> tmp_lcp;
+    perm.ensure_capacity(n);
+    lcp.ensure_capacity(n);
+    tmp_idx.ensure_capacity(n);
+    tmp_lcp.ensure_capacity(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        perm.emplace_back(i);
+        lcp.emplace_back((size_t)0);
+        tmp_idx.emplace_back((size_t)0);
+        tmp_lcp.emplace_back((size_t)0);
+    }
+
+    lcp_merge_sort(start, perm.begin(), lcp.begin(), tmp_idx.begin(),
+            tmp_lcp.begin(), n);
+    permute_inplace(start, end, perm);
+}
+}
+
+#endif
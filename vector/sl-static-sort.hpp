@@ -0,0 +1,319 @@
+/*
+ * Experimentation with sorting networks for small arrays whose size is
+ * known at compile time
+ */
+#ifndef SL_STATIC_SORT_HPP
+#define SL_STATIC_SORT_HPP
+
+#if __cplusplus < 201703L
+#error "sl-static-sort.hpp needs C++17, build with scons std=c++17"
+#endif
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include "sl-static-vector.hpp"
+
+namespace sll
+{
+/**
+ * Largest size which is sorted with a fully unrolled sorting network, since
+ * the unrolled code grows with N log^2 N. Larger arrays are sorted in runs
+ * of this size, which are then merged.
+ */
+constexpr size_t MAX_NETWORK_SIZE = 32;
+
+/**
+ * Largest array, in bytes, which is sorted by merging runs. The merge
+ * buffer lives on the stack so that it stays constexpr, larger arrays
+ * should use sll::heap_sort or std::sort.
+ */
+constexpr size_t MAX_STATIC_SORT_BYTES = 64 * 1024;
+
+/**
+ * Sort the array a according to c. Everything is constexpr, so this can be
+ * used to build sorted lookup tables at compile time.
+ *
+ * For N <= MAX_NETWORK_SIZE the array is sorted with Batcher's odd-even
+ * merge exchange network. The sequence of compare-exchanges is computed at
+ * compile time, then expanded into straight line code with constant
+ * indices, so there are no loops, calls or unpredictable branches left at
+ * runtime; each compare-exchange is a pair of conditional moves. Larger
+ * arrays are split into runs sorted by the network, which are then merged,
+ * up to MAX_STATIC_SORT_BYTES.
+ *
+ * This is not a stable sort.
+ */
+template <class T, size_t N, class Compare>
+constexpr void sort(std::array<T, N> & a, Compare c);
+
+/**
+ * Sort the array according to the default less operator.
+ */
+template <class T, size_t N>
+constexpr void sort(std::array<T, N> & a);
+
+/**
+ * Sort the elements of v according to c. The size is only known at
+ * runtime, so this dispatches to the network for v.size() elements, or
+ * merges runs sorted with the network above MAX_NETWORK_SIZE elements.
+ */
+template <class T, size_t N, class Compare>
+constexpr void sort(stll::static_vector<T, N> & v, Compare c);
+
+/**
+ * Sort the elements of v according to the default less operator.
+ */
+template <class T, size_t N>
+constexpr void sort(stll::static_vector<T, N> & v);
+
+/**
+ * One compare-exchange of a sorting network, after which the element at a
+ * is not greater than the element at b.
+ */
+struct comparator
+{
+    size_t a;
+    size_t b;
+};
+
+/**
+ * Walk Batcher's merge exchange network for n elements (Knuth, TAOCP vol 3,
+ * algorithm 5.2.2M), calling f(i, j) for each compare-exchange in order.
+ */
+template <class Function>
+constexpr void merge_exchange_network(size_t n, Function f);
+
+/**
+ * Get the number of compare-exchanges in the network for N elements
+ */
+template <size_t N>
+constexpr size_t network_size(void);
+
+/**
+ * Get the compare-exchanges in the network for N elements
+ */
+template <size_t N>
+constexpr std::array<comparator, network_size<N>()> network(void);
+
+/**
+ * Order the elements at i and j without branching
+ */
+template <class T, class Compare>
+constexpr void compare_exchange(T * data, size_t i, size_t j, Compare c);
+
+/**
+ * Apply the network for N elements to data, unrolled over the comparator
+ * indices I
+ */
+template <size_t N, class T, class Compare, size_t... I>
+constexpr void apply_network(T * data, Compare c, std::index_sequence<I...>);
+
+/**
+ * Sort the N elements at data with the network, or by merging runs sorted
+ * with the network if N is larger than MAX_NETWORK_SIZE
+ */
+template <size_t N, class T, class Compare>
+constexpr void static_sort(T * data, Compare c);
+
+/**
+ * Sort the n elements at data, picking the network for n at runtime from
+ * those for 0 .. N, which must be at most MAX_NETWORK_SIZE
+ */
+template <size_t N, class T, class Compare>
+constexpr void static_sort_dispatch(T * data, size_t n, Compare c);
+
+/**
+ * Sort the n elements at data by sorting runs of MAX_NETWORK_SIZE with the
+ * network, then merging them bottom up through buffer, which has room for
+ * n elements
+ */
+template <class T, class Compare>
+constexpr void merge_sort_runs(T * data, size_t n, T * buffer, Compare c);
+
+
+template <class Function>
+constexpr void merge_exchange_network(size_t n, Function f)
+{
+    if (n < 2) return;
+
+    size_t t = 1;
+    while (((size_t)1 << t) < n)
+    {
+        t++;
+    }
+
+    for (size_t p = (size_t)1 << (t - 1); p > 0; p >>= 1)
+    {
+        size_t q = (size_t)1 << (t - 1);
+        size_t r = 0;
+        size_t d = p;
+        while (true)
+        {
+            for (size_t i = 0; i + d < n; i++)
+            {
+                if ((i & p) == r)
+                {
+                    f(i, i + d);
+                }
+            }
+            if (q == p) break;
+            d = q - p;
+            q >>= 1;
+            r = p;
+        }
+    }
+}
+
+template <size_t N>
+constexpr size_t network_size(void)
+{
+    size_t count = 0;
+    merge_exchange_network(N, [&count](size_t, size_t) { count++; });
+    return count;
+}
+
+template <size_t N>
+constexpr std::array<comparator, network_size<N>()> network(void)
+{
+    std::array<comparator, network_size<N>()> comparators = {};
+    size_t k = 0;
+    merge_exchange_network(N, [&comparators, &k](size_t i, size_t j) {
+        comparators[k] = comparator{i, j};
+        k++;
+    });
+    return comparators;
+}
+
+template <class T, class Compare>
+constexpr void compare_exchange(T * data, size_t i, size_t j, Compare c)
+{
+    T x = data[i];
+    T y = data[j];
+    bool swap = c(y, x);
+    data[i] = swap ? y : x;
+    data[j] = swap ? x : y;
+}
+
+template <size_t N, class T, class Compare, size_t... I>
+constexpr void apply_network(T * data, Compare c, std::index_sequence<I...>)
+{
+    constexpr auto comparators = network<N>();
+    (compare_exchange(data, comparators[I].a, comparators[I].b, c), ...);
+}
+
+template <size_t N, class T, class Compare>
+constexpr void static_sort(T * data, Compare c)
+{
+    if constexpr (N < 2)
+    {
+        return;
+    }
+    else if constexpr (N <= MAX_NETWORK_SIZE)
+    {
+        apply_network<N>(data, c, std::make_index_sequence<network_size<N>()>());
+    }
+    else
+    {
+        static_assert(N * sizeof(T) <= MAX_STATIC_SORT_BYTES,
+                "array is too large to sort with a stack buffer");
+        T buffer[N] = {};
+        merge_sort_runs(data, N, buffer, c);
+    }
+}
+
+template <size_t N, class T, class Compare>
+constexpr void static_sort_dispatch(T * data, size_t n, Compare c)
+{
+    static_assert(N <= MAX_NETWORK_SIZE, "dispatch only covers the networks");
+
+    if (n == N)
+    {
+        static_sort<N>(data, c);
+    }
+    else if constexpr (N > 0)
+    {
+        static_sort_dispatch<N - 1>(data, n, c);
+    }
+}
+
+template <class T, class Compare>
+constexpr void merge_sort_runs(T * data, size_t n, T * buffer, Compare c)
+{
+    constexpr size_t R = MAX_NETWORK_SIZE;
+    size_t full = n - n % R;
+    for (size_t i = 0; i < full; i += R)
+    {
+        static_sort<R>(data + i, c);
+    }
+    static_sort_dispatch<R - 1>(data + full, n - full, c);
+
+    for (size_t width = R; width < n; width *= 2)
+    {
+        for (size_t lo = 0; lo < n; lo += 2 * width)
+        {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t i = lo;
+            size_t j = mid;
+            for (size_t k = lo; k < hi; k++)
+            {
+                if (j == hi || (i < mid && !c(data[j], data[i])))
+                {
+                    buffer[k] = data[i++];
+                }
+                else
+                {
+                    buffer[k] = data[j++];
+                }
+            }
+        }
+        for (size_t k = 0; k < n; k++)
+        {
+            data[k] = buffer[k];
+        }
+    }
+}
+
+template <class T, size_t N, class Compare>
+constexpr void sort(std::array<T, N> & a, Compare c)
+{
+    static_sort<N>(a.data(), c);
+}
+
+template <class T, size_t N>
+constexpr void sort(std::array<T, N> & a)
+{
+    sort(a, std::less<T>());
+}
+
+template <class T, size_t N, class Compare>
+constexpr void sort(stll::static_vector<T, N> & v, Compare c)
+{
+    if constexpr (N <= MAX_NETWORK_SIZE)
+    {
+        static_sort_dispatch<N>(v.begin(), v.size(), c);
+    }
+    else if (v.size() <= MAX_NETWORK_SIZE)
+    {
+        static_sort_dispatch<MAX_NETWORK_SIZE>(v.begin(), v.size(), c);
+    }
+    else
+    {
+        static_assert(N * sizeof(T) <= MAX_STATIC_SORT_BYTES,
+                "static_vector is too large to sort with a stack buffer");
+        T buffer[N] = {};
+        merge_sort_runs(v.begin(), v.size(), buffer, c);
+    }
+}
+
+template <class T, size_t N>
+constexpr void sort(stll::static_vector<T, N> & v)
+{
+    sort(v, std::less<T>());
+}
+}
+
+#endif
@@ -0,0 +1,174 @@
+/*
+ * Experimentation with fixed capacity containers which never allocate
+ */
+#ifndef SL_STATIC_VECTOR_HPP
+#define SL_STATIC_VECTOR_HPP
+
+#if __cplusplus < 201703L
+#error "sl-static-vector.hpp needs C++17, build with scons std=c++17"
+#endif
+
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+
+// STL learning namespace
+namespace stll
+{
+
+/**
+ * A vector with room for at most N elements, stored inline. It never
+ * allocates, so it can live on the stack, and everything is constexpr so
+ * it can be filled and sorted at compile time.
+ *
+ * To stay usable in constant expressions the storage is a plain array of
+ * N elements, so T must be default constructible. Elements past size() are
+ * default constructed and unused.
+ */
+template<typename T, size_t N> class static_vector {
+    typedef T*    iterator;
+
+    protected:
+        T m_data[N > 0 ? N : 1] = {};
+        size_t m_size = 0;
+
+    public:
+        /**
+         * Use a default constructor
+         */
+        constexpr static_vector(void) = default;
+
+        /**
+         * Create a vector holding the listed elements, at most N of them
+         */
+        constexpr static_vector(std::initializer_list<T> init);
+
+        /**
+         * Construct a new element T with the provided arguments. The vector
+         * must not be full.
+         */
+        template<class ...Args> constexpr void emplace_back(Args&&... args);
+
+        /**
+         * Access a reference to the element stored at the provided index
+         */
+        constexpr T & operator [](size_t index) noexcept;
+
+        /**
+         * Read the element stored at the provided index
+         */
+        constexpr const T & operator [](size_t index) const noexcept;
+
+        /**
+         * Delete the last element in the vector
+         */
+        constexpr void pop_back(void) noexcept;
+
+        constexpr bool empty(void) const noexcept;
+
+        constexpr bool full(void) const noexcept;
+
+        constexpr iterator begin(void) noexcept;
+
+        constexpr iterator end(void) noexcept;
+
+        constexpr const T * begin(void) const noexcept;
+
+        constexpr const T * end(void) const noexcept;
+
+        constexpr size_t size(void) const noexcept;
+
+        constexpr static size_t capacity(void) noexcept;
+};
+
+template<typename T, size_t N>
+constexpr static_vector<T, N>::static_vector(std::initializer_list<T> init)
+{
+    for (const T & val : init)
+    {
+        this->emplace_back(val);
+    }
+}
+
+template<typename T, size_t N>
+template<class ...Args>
+constexpr void static_vector<T, N>::emplace_back(Args&&... args)
+{
+    // Need to guard this in debug mode
+    this->m_data[this->m_size] = T(std::forward<Args>(args)...);
+    this->m_size ++;
+}
+
+template<typename T, size_t N>
+constexpr T & static_vector<T, N>::operator [](size_t index) noexcept
+{
+    // Need to guard this in debug mode
+    return this->m_data[index];
+}
+
+template<typename T, size_t N>
+constexpr const T & static_vector<T, N>::operator [](size_t index) const noexcept
+{
+    // Need to guard this in debug mode
+    return this->m_data[index];
+}
+
+template<typename T, size_t N>
+constexpr void static_vector<T, N>::pop_back(void) noexcept
+{
+    // Need to guard this in debug mode
+    -- this->m_size;
+    this->m_data[this->m_size] = T();
+}
+
+template<typename T, size_t N>
+constexpr bool static_vector<T, N>::empty(void) const noexcept
+{
+    return this->m_size == 0;
+}
+
+template<typename T, size_t N>
+constexpr bool static_vector<T, N>::full(void) const noexcept
+{
+    return this->m_size == N;
+}
+
+template<typename T, size_t N>
+constexpr typename static_vector<T, N>::iterator static_vector<T, N>::begin(void) noexcept
+{
+    return this->m_data;
+}
+
+template<typename T, size_t N>
+constexpr typename static_vector<T, N>::iterator static_vector<T, N>::end(void) noexcept
+{
+    return this->m_data + this->m_size;
+}
+
+template<typename T, size_t N>
+constexpr const T * static_vector<T, N>::begin(void) const noexcept
+{
+    return this->m_data;
+}
+
+template<typename T, size_t N>
+constexpr const T * static_vector<T, N>::end(void) const noexcept
+{
+    return this->m_data + this->m_size;
+}
+
+template<typename T, size_t N>
+constexpr size_t static_vector<T, N>::size(void) const noexcept
+{
+    return this->m_size;
+}
+
+template<typename T, size_t N>
+constexpr size_t static_vector<T, N>::capacity(void) noexcept
+{
+    return N;
+}
+
+}
+
+#endif
@@ -1,5 +1,13 @@
+#ifndef SL_VECTOR_HPP
+#define SL_VECTOR_HPP
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 // STL learning namespace
 namespace stll
@@ -14,6 +22,15 @@ template <typename T> T min(const T & a, const T & b)
     return b;
 }
 
+template <typename T> T max(const T & a, const T & b)
+{
+    if (a < b)
+    {
+        return b;
+    }
+    return a;
+}
+
 
 template<typename T> class vector {
     typedef T*    iterator;
@@ -25,8 +42,17 @@ template<typename T> class vector {
         size_t m_capacity = 0;
         void grow();
         void _delete();
+        void reallocate(size_t new_capacity);
+        size_t grown_capacity(size_t needed) const noexcept;
         template<class ...Args> void unsafe_emplace_back(Args&&... args);
 
+        /**
+         * Check whether x is one of the elements of this vector. Only an
+         * lvalue of type T can be.
+         */
+        bool holds(const T & x) const noexcept;
+        template<class U> bool holds(const U & x) const noexcept;
+
     public:
         /**
          * Use a default constructor
@@ -89,6 +115,55 @@ template<typename T> class vector {
          */
         void ensure_capacity(size_t capacity);
 
+        /**
+         * Insert copies of the elements in [first, last) before pos. This
+         * reallocates at most once, and only moves the elements after pos
+         * once. The range may be part of this vector, it is then copied
+         * out first unless the vector has to reallocate anyway. Returns an
+         * iterator to the first inserted element.
+         */
+        template<class ForwardIt>
+        iterator insert(iterator pos, ForwardIt first, ForwardIt last);
+
+        /**
+         * Append copies of the elements in [first, last), with at most one
+         * reallocation. The range may be part of this vector.
+         */
+        template<class ForwardIt> void append_range(ForwardIt first, ForwardIt last);
+
+        /**
+         * Append copies of the elements of range
+         */
+        template<class Range> void append_range(const Range & range);
+
+        /**
+         * Remove the elements in [first, last), moving the following
+         * elements down once. Returns an iterator to the element after the
+         * removed ones.
+         */
+        iterator erase(iterator first, iterator last);
+
+        /**
+         * Remove every element for which p returns true, in a single pass
+         * which keeps the order of the remaining elements. Returns the
+         * number of elements removed.
+         */
+        template<class Predicate> size_t erase_if(Predicate p);
+
+        /**
+         * Change the size to count without initializing new elements, so
+         * that they can be filled in directly. Only allowed for trivial
+         * types, the new elements hold garbage until they are written.
+         */
+        void resize_uninitialized(size_t count);
+
+        /**
+         * Release unused capacity
+         */
+        void shrink_to_fit(void);
+
+        size_t capacity(void) const noexcept;
+
         iterator begin(void) const noexcept;
 
         iterator end(void) const noexcept;
@@ -292,17 +367,252 @@ void vector<T>::grow()
 template<typename T>
 void vector<T>::ensure_capacity(size_t new_capacity)
 {
-    if (new_capacity < this->m_capacity) return;
+    if (new_capacity <= this->m_capacity) return;
 
-    // Check that new_size > m_size?
+    this->reallocate(new_capacity);
+}
+
+/**
+ * Move the elements into a new buffer with room for new_capacity elements,
+ * which must be at least m_size
+ */
+template<typename T>
+void vector<T>::reallocate(size_t new_capacity)
+{
+    T * tmp_data = nullptr;
+    if (new_capacity > 0)
+    {
+        tmp_data = (T*) (operator new(sizeof(T) * new_capacity));
+    }
+    // The new buffer is raw memory, so construct into it rather than
+    // assigning
+    for (size_t i = 0; i < this->m_size; i++)
+    {
+        new(tmp_data + i) T(std::move(this->m_data[i]));
+        this->m_data[i].~T();
+    }
+    operator delete(this->m_data);
+    this->m_data = tmp_data;
+    this->m_capacity = new_capacity;
+}
+
+/**
+ * Get the capacity to grow to so that there is room for needed elements.
+ * Growing geometrically keeps repeated bulk appends amortized O(1) per
+ * element.
+ */
+template<typename T>
+size_t vector<T>::grown_capacity(size_t needed) const noexcept
+{
+    if (needed <= this->m_capacity) return this->m_capacity;
+
+    return max<size_t>(needed, this->m_size * SCALE_FACTOR);
+}
+
+template<typename T>
+template<class ForwardIt>
+typename vector<T>::iterator vector<T>::insert(vector<T>::iterator pos,
+        ForwardIt first, ForwardIt last)
+{
+    size_t index = pos - this->m_data;
+    size_t n = std::distance(first, last);
+    if (n == 0) return this->m_data + index;
+
+    size_t tail = this->m_size - index;
+    if (this->m_size + n > this->m_capacity)
+    {
+        // Build the result directly in the new buffer, so every element is
+        // moved once. The range is copied before anything is moved out of
+        // the old buffer, in case it is part of this vector.
+        size_t new_capacity = this->grown_capacity(this->m_size + n);
+        T * tmp_data = (T*) (operator new(sizeof(T) * new_capacity));
+        T * out = tmp_data + index;
+        for (; first != last; ++first, ++out)
+        {
+            new(out) T(*first);
+        }
+        for (size_t i = 0; i < index; i++)
+        {
+            new(tmp_data + i) T(std::move(this->m_data[i]));
+        }
+        for (size_t i = index; i < this->m_size; i++)
+        {
+            new(tmp_data + n + i) T(std::move(this->m_data[i]));
+        }
+
+        for (size_t i = 0; i < this->m_size; i++)
+        {
+            this->m_data[i].~T();
+        }
+        operator delete(this->m_data);
+        this->m_data = tmp_data;
+        this->m_capacity = new_capacity;
+    }
+    else if (this->holds(*first))
+    {
+        // Shifting the tail would move elements out from under the range
+        vector<T> copy;
+        copy.append_range(first, last);
+        return this->insert(this->m_data + index, copy.begin(), copy.end());
+    }
+    else if (tail > n)
+    {
+        // The last n elements move into raw memory past the end, the rest
+        // of the tail shifts up over live elements
+        T * end = this->m_data + this->m_size;
+        for (size_t i = 0; i < n; i++)
+        {
+            new(end + i) T(std::move(*(end - n + i)));
+        }
+        std::move_backward(this->m_data + index, end - n, end);
+        std::copy(first, last, this->m_data + index);
+    }
+    else
+    {
+        // The inserted elements reach past the end, so the whole tail moves
+        // into raw memory, along with the inserted elements past the end
+        ForwardIt mid = first;
+        std::advance(mid, tail);
+        T * out = this->m_data + this->m_size;
+        for (ForwardIt it = mid; it != last; ++it, ++out)
+        {
+            new(out) T(*it);
+        }
+        for (size_t i = index; i < this->m_size; i++, ++out)
+        {
+            new(out) T(std::move(this->m_data[i]));
+        }
+        std::copy(first, mid, this->m_data + index);
+    }
+    this->m_size += n;
+
+    return this->m_data + index;
+}
+
+template<typename T>
+bool vector<T>::holds(const T & x) const noexcept
+{
+    std::less<const T *> less;
+    return !less(&x, this->m_data) && less(&x, this->m_data + this->m_size);
+}
+
+template<typename T>
+template<class U>
+bool vector<T>::holds(const U &) const noexcept
+{
+    return false;
+}
+
+template<typename T>
+template<class ForwardIt>
+void vector<T>::append_range(ForwardIt first, ForwardIt last)
+{
+    size_t n = std::distance(first, last);
+    if (this->m_size + n <= this->m_capacity)
+    {
+        // No capacity checks left inside the loop
+        T * out = this->m_data + this->m_size;
+        for (; first != last; ++first, ++out)
+        {
+            new(out) T(*first);
+        }
+        this->m_size += n;
+        return;
+    }
+
+    // Copy the range into the new buffer before the old elements are moved
+    // out and freed, in case the range is part of this vector
+    size_t new_capacity = this->grown_capacity(this->m_size + n);
     T * tmp_data = (T*) (operator new(sizeof(T) * new_capacity));
+    T * out = tmp_data + this->m_size;
+    for (; first != last; ++first, ++out)
+    {
+        new(out) T(*first);
+    }
     for (size_t i = 0; i < this->m_size; i++)
     {
-        tmp_data[i] = std::move(this->m_data[i]);
+        new(tmp_data + i) T(std::move(this->m_data[i]));
+        this->m_data[i].~T();
     }
     operator delete(this->m_data);
     this->m_data = tmp_data;
     this->m_capacity = new_capacity;
+    this->m_size += n;
+}
+
+template<typename T>
+template<class Range>
+void vector<T>::append_range(const Range & range)
+{
+    this->append_range(std::begin(range), std::end(range));
+}
+
+template<typename T>
+typename vector<T>::iterator vector<T>::erase(vector<T>::iterator first,
+        vector<T>::iterator last)
+{
+    size_t n = last - first;
+    if (n == 0) return first;
+
+    std::move(last, this->end(), first);
+    for (size_t i = 0; i < n; i++)
+    {
+        this->pop_back();
+    }
+    return first;
+}
+
+template<typename T>
+template<class Predicate>
+size_t vector<T>::erase_if(Predicate p)
+{
+    // Kept elements are moved down over removed ones as they are found,
+    // so each element is tested and moved at most once
+    T * out = this->m_data;
+    T * end = this->m_data + this->m_size;
+    for (T * it = this->m_data; it != end; ++it)
+    {
+        if (!p(*it))
+        {
+            if (out != it)
+            {
+                *out = std::move(*it);
+            }
+            ++out;
+        }
+    }
+
+    size_t removed = end - out;
+    for (size_t i = 0; i < removed; i++)
+    {
+        this->pop_back();
+    }
+    return removed;
+}
+
+template<typename T>
+void vector<T>::resize_uninitialized(size_t count)
+{
+    static_assert(std::is_trivially_default_constructible<T>::value
+            && std::is_trivially_destructible<T>::value,
+            "resize_uninitialized needs a trivial type");
+
+    this->ensure_capacity(this->grown_capacity(count));
+    this->m_size = count;
+}
+
+template<typename T>
+void vector<T>::shrink_to_fit(void)
+{
+    if (this->m_capacity == this->m_size) return;
+
+    this->reallocate(this->m_size);
+}
+
+template<typename T>
+size_t vector<T>::capacity(void) const noexcept
+{
+    return this->m_capacity;
 }
 
 template<typename T>
@@ -338,3 +648,5 @@ size_t vector<T>::size(void) const noexcept
 }
 
 }
+
+#endif
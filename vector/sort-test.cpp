@@ -8,8 +8,10 @@
 // Need for ostream
 #include <iostream>
 #include <list>
+#include <string>
 
 // This is what I'm using to compare to
+#include <algorithm>
 #include <vector>
 
 // Use widget to test with a self-defined class
@@ -18,6 +20,10 @@
 #include "sl-sort.hpp"
 
 constexpr size_t MAX_VECTOR_SIZE = 5000000;
+// Total bytes of records sorted by the wide record tests
+constexpr size_t RECORD_BYTES = 256000000;
+// Number of strings sorted by the string tests
+constexpr size_t N_STRINGS = 1000000;
 static int random_numbers[MAX_VECTOR_SIZE];
 static struct timeval start_time;
 
@@ -101,6 +107,182 @@ ResultList test_sort()
     return resultlist;
 }
 
+/*
+ * A wide record with an integer key at the front and BYTES - sizeof(int)
+ * bytes of payload which has to move along with the key.
+ */
+template <size_t BYTES>
+struct Record
+{
+    int key;
+    char payload[BYTES - sizeof(int)];
+
+    bool operator<(const Record & other) const
+    {
+        return this->key < other.key;
+    }
+};
+
+/*
+ * Sort RECORD_BYTES worth of BYTES-wide records directly and indirectly
+ * through a permutation.
+ */
+template <size_t BYTES>
+ResultList test_record_sort()
+{
+    ResultList resultlist;
+    typedef Record<BYTES> R;
+    size_t n = std::min(RECORD_BYTES / BYTES, MAX_VECTOR_SIZE);
+
+    std::vector<R> records(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        records[i].key = random_numbers[i];
+        records[i].payload[0] = (char)i;
+    }
+
+    std::vector<R> vec1(records);
+    init_start_time();
+    std::sort(vec1.begin(), vec1.end());
+    resultlist.emplace_back("QSort records time", get_time());
+
+    std::vector<R> vec2(records);
+    init_start_time();
+    sll::heap_sort(vec2.begin(), vec2.end());
+    resultlist.emplace_back("Heapify records time", get_time());
+
+    std::vector<R> vec3(n);
+    init_start_time();
+    auto perm = sll::argsort(records.begin(), records.end());
+    resultlist.emplace_back("Argsort time", get_time());
+    init_start_time();
+    sll::apply_permutation(records.begin(), perm, vec3.begin());
+    resultlist.emplace_back("Apply permutation time", get_time());
+
+    init_start_time();
+    auto prefix_perm = sll::argsort_by_prefix(records.begin(), records.end(),
+            [](const R & r) { return r.key; }, std::less<R>());
+    resultlist.emplace_back("Argsort by prefix time", get_time());
+
+    std::vector<R> vec4(records);
+    init_start_time();
+    sll::permute_inplace(vec4.begin(), vec4.end(), prefix_perm);
+    resultlist.emplace_back("Permute in place time", get_time());
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (vec1[i].key != vec2[i].key || vec1[i].key != vec3[i].key
+                || vec1[i].key != vec4[i].key)
+        {
+            std::cout << "ERROR: record sorts disagree at " << i << std::endl;
+            break;
+        }
+    }
+
+    return resultlist;
+}
+
+/*
+ * Build a random string of lowercase letters with length in [min, max)
+ */
+static std::string random_string(size_t min, size_t max)
+{
+    size_t len = min + rand() % (max - min);
+    std::string s;
+    for (size_t i = 0; i < len; i++)
+    {
+        s.push_back('a' + rand() % 26);
+    }
+    return s;
+}
+
+/*
+ * URL-like strings, a handful of hosts followed by a few path segments
+ */
+static std::vector<std::string> url_strings(void)
+{
+    static const char * hosts[] = {
+        "https://www.example.com/", "https://api.example.com/v1/",
+        "http://cdn.example.org/static/", "https://docs.example.net/en/latest/",
+    };
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < N_STRINGS; i++)
+    {
+        std::string s = hosts[rand() % 4];
+        size_t segments = 1 + rand() % 4;
+        for (size_t j = 0; j < segments; j++)
+        {
+            s += random_string(3, 10);
+            s += '/';
+        }
+        strings.emplace_back(s);
+    }
+    return strings;
+}
+
+/*
+ * Strings which all share a 64 character prefix and differ in a short tail
+ */
+static std::vector<std::string> shared_prefix_strings(void)
+{
+    std::string prefix(64, 'x');
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < N_STRINGS; i++)
+    {
+        strings.emplace_back(prefix + random_string(1, 8));
+    }
+    return strings;
+}
+
+/*
+ * Random strings with no structure
+ */
+static std::vector<std::string> random_strings(void)
+{
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < N_STRINGS; i++)
+    {
+        strings.emplace_back(random_string(4, 32));
+    }
+    return strings;
+}
+
+/*
+ * Sort the strings with std::sort, heap_sort, multikey quicksort and LCP
+ * merge sort.
+ */
+ResultList test_string_sort(const std::vector<std::string> & strings)
+{
+    ResultList resultlist;
+
+    std::vector<std::string> vec1(strings);
+    init_start_time();
+    std::sort(vec1.begin(), vec1.end());
+    resultlist.emplace_back("QSort strings time", get_time());
+
+    std::vector<std::string> vec2(strings);
+    init_start_time();
+    sll::heap_sort(vec2.begin(), vec2.end());
+    resultlist.emplace_back("Heapify strings time", get_time());
+
+    std::vector<std::string> vec3(strings);
+    init_start_time();
+    sll::string_sort(vec3.begin(), vec3.end());
+    resultlist.emplace_back("Multikey quicksort time", get_time());
+
+    std::vector<std::string> vec4(strings);
+    init_start_time();
+    sll::string_merge_sort(vec4.begin(), vec4.end());
+    resultlist.emplace_back("LCP merge sort time", get_time());
+
+    if (vec1 != vec2 || vec1 != vec3 || vec1 != vec4)
+    {
+        std::cout << "ERROR: string sorts disagree" << std::endl;
+    }
+
+    return resultlist;
+}
+
 
 int main()
 {
@@ -112,5 +294,23 @@ int main()
 
     std::cout << heapify_results;
 
+    std::cout << "\n64 byte record times" << std::endl;
+    std::cout << test_record_sort<64>();
+
+    std::cout << "\n256 byte record times" << std::endl;
+    std::cout << test_record_sort<256>();
+
+    std::cout << "\n1024 byte record times" << std::endl;
+    std::cout << test_record_sort<1024>();
+
+    std::cout << "\nURL-like string times" << std::endl;
+    std::cout << test_string_sort(url_strings());
+
+    std::cout << "\nShared prefix string times" << std::endl;
+    std::cout << test_string_sort(shared_prefix_strings());
+
+    std::cout << "\nRandom string times" << std::endl;
+    std::cout << test_string_sort(random_strings());
+
     return 0;
 }
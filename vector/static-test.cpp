@@ -0,0 +1,193 @@
+// TODO replace this with platform-agnostic version at
+// http://nadeausoftware.com/articles/2012/04/c_c_tip_how_measure_elapsed_real_time_benchmarking
+// or similar
+#include <sys/time.h>
+
+// Need malloc and rand
+#include <cstdlib>
+// Need for ostream
+#include <iostream>
+#include <list>
+
+// This is what I'm using to compare to
+#include <algorithm>
+#include <array>
+#include <vector>
+
+// This is my test file
+#include "sl-sort.hpp"
+#include "sl-static-sort.hpp"
+
+// Total number of elements sorted for each fixed size
+constexpr size_t MAX_VECTOR_SIZE = 16000000;
+static int random_numbers[MAX_VECTOR_SIZE];
+static struct timeval start_time;
+
+/*
+ * A lookup table which is sorted by the compiler, nothing is left to do at
+ * runtime.
+ */
+constexpr std::array<int, 8> sorted_table = [] {
+    std::array<int, 8> table = {42, 7, 19, 3, 88, 1, 56, 23};
+    sll::sort(table);
+    return table;
+}();
+static_assert(sorted_table[0] == 1 && sorted_table[7] == 88,
+        "table should be sorted at compile time");
+
+constexpr stll::static_vector<int, 32> sorted_static_vector = [] {
+    stll::static_vector<int, 32> v = {5, 4, 3, 2, 1};
+    sll::sort(v, std::greater<int>());
+    return v;
+}();
+static_assert(sorted_static_vector.size() == 5 && sorted_static_vector[0] == 5
+        && sorted_static_vector[4] == 1,
+        "static_vector should be sorted at compile time");
+
+/*
+ * Convenience function for setting the current time
+ */
+static void init_start_time(void)
+{
+    gettimeofday(&start_time, NULL);
+}
+
+/*
+ * Convenience function for getting the time since the last call to
+ * init_start_time
+ */
+static double get_time(void)
+{
+    struct timeval end_time;
+    gettimeofday(&end_time, NULL);
+    double diff = (double)(end_time.tv_sec - start_time.tv_sec)
+                + (double)(end_time.tv_usec - start_time.tv_usec) / 1e6;
+
+    return diff;
+}
+
+/*
+ * Initialize the random numbers used in the rest of the testing
+ */
+static void initialize_random_numbers(void)
+{
+    for (size_t i = 0; i < MAX_VECTOR_SIZE; i++)
+    {
+        random_numbers[i] = (int)rand();
+    }
+}
+
+struct TimeResult
+{
+    public:
+        std::string tag;
+        double time;
+        TimeResult(std::string tag, double time)
+        {
+            this->tag = tag;
+            this->time = time;
+        }
+};
+
+class ResultList : public std::list<TimeResult>
+{
+};
+
+std::ostream& operator<< (std::ostream & o, ResultList r)
+{
+    for (auto tr : r)
+    {
+        o << tr.tag << ": " << tr.time << std::endl;
+    }
+    return o;
+}
+
+/*
+ * Sort MAX_VECTOR_SIZE / N arrays of N random integers each, with std::sort,
+ * heap_sort, the sorting network on std::array and the sorting network on
+ * a full static_vector.
+ */
+template <size_t N>
+ResultList test_static_sort()
+{
+    ResultList resultlist;
+    constexpr size_t n_arrays = MAX_VECTOR_SIZE / N;
+    typedef std::array<int, N> A;
+
+    std::vector<A> arrays(n_arrays);
+    std::vector<stll::static_vector<int, N>> vectors(n_arrays);
+    for (size_t i = 0; i < n_arrays; i++)
+    {
+        for (size_t j = 0; j < N; j++)
+        {
+            arrays[i][j] = random_numbers[i * N + j];
+            vectors[i].emplace_back(random_numbers[i * N + j]);
+        }
+    }
+
+    std::vector<A> vec1(arrays);
+    init_start_time();
+    for (auto & a : vec1)
+    {
+        std::sort(a.begin(), a.end());
+    }
+    resultlist.emplace_back("QSort time", get_time());
+
+    std::vector<A> vec2(arrays);
+    init_start_time();
+    for (auto & a : vec2)
+    {
+        sll::heap_sort(a.begin(), a.end());
+    }
+    resultlist.emplace_back("Heapify time", get_time());
+
+    std::vector<A> vec3(arrays);
+    init_start_time();
+    for (auto & a : vec3)
+    {
+        sll::sort(a);
+    }
+    resultlist.emplace_back("Network time", get_time());
+
+    init_start_time();
+    for (auto & v : vectors)
+    {
+        sll::sort(v);
+    }
+    resultlist.emplace_back("Static vector network time", get_time());
+
+    for (size_t i = 0; i < n_arrays; i++)
+    {
+        if (vec1[i] != vec2[i] || vec1[i] != vec3[i]
+                || !std::equal(vec1[i].begin(), vec1[i].end(), vectors[i].begin()))
+        {
+            std::cout << "ERROR: fixed size sorts disagree" << std::endl;
+            break;
+        }
+    }
+
+    return resultlist;
+}
+
+
+int main()
+{
+    initialize_random_numbers();
+
+    std::cout << "4 element sort times" << std::endl;
+    std::cout << test_static_sort<4>() << std::endl;
+
+    std::cout << "8 element sort times" << std::endl;
+    std::cout << test_static_sort<8>() << std::endl;
+
+    std::cout << "16 element sort times" << std::endl;
+    std::cout << test_static_sort<16>() << std::endl;
+
+    std::cout << "32 element sort times" << std::endl;
+    std::cout << test_static_sort<32>() << std::endl;
+
+    std::cout << "64 element (merged networks) times" << std::endl;
+    std::cout << test_static_sort<64>() << std::endl;
+
+    return 0;
+}
@@ -9,15 +9,28 @@
 // Need for ostream
 #include <iostream>
 #include <list>
+#include <thread>
 
 // This is what I'm using to compare to
+#include <algorithm>
 #include <vector>
 
 // Use widget to test with a self-defined class
 #include "widget.hpp"
 #include "sl-vector.hpp"
+#include "sl-shared-vector.hpp"
 
 constexpr size_t MAX_VECTOR_SIZE = 100000000;
+// Size of the vector shared between reader threads and a writer
+constexpr size_t CONTENDED_VECTOR_SIZE = 1000000;
+constexpr size_t N_PUBLISHES = 100;
+// Versions published by each writer in the published vector stress check
+constexpr size_t N_STRESS_PUBLISHES = 20000;
+constexpr size_t STRESS_VECTOR_SIZE = 64;
+// Number of elements handed over at once by the bulk operations
+constexpr size_t BATCH_SIZE = 1000;
+// Number of batches inserted into and erased from the middle of the vector
+constexpr size_t N_MIDDLE_BATCHES = 10;
 static int random_numbers[MAX_VECTOR_SIZE];
 static struct timeval start_time;
 
@@ -151,6 +164,326 @@ template<typename T, size_t N> ResultList test_vector_int()
     return resultlist;
 }
 
+/*
+ * The bulk operations are spelled differently on the two vectors, these
+ * give them the same names for test_vector_bulk.
+ */
+static void append_batch(std::vector<int> & vec, const int * b, const int * e)
+{
+    vec.insert(vec.end(), b, e);
+}
+
+static void append_batch(stll::vector<int> & vec, const int * b, const int * e)
+{
+    vec.append_range(b, e);
+}
+
+static void resize_for_fill(std::vector<int> & vec, size_t n)
+{
+    vec.resize(n);
+}
+
+static void resize_for_fill(stll::vector<int> & vec, size_t n)
+{
+    vec.resize_uninitialized(n);
+}
+
+template<class Predicate>
+static size_t filter(std::vector<int> & vec, Predicate p)
+{
+    size_t n = vec.size();
+    vec.erase(std::remove_if(vec.begin(), vec.end(), p), vec.end());
+    return n - vec.size();
+}
+
+template<class Predicate>
+static size_t filter(stll::vector<int> & vec, Predicate p)
+{
+    return vec.erase_if(p);
+}
+
+/*
+ * Insert the elements [first, last) of vec into itself before pos, and
+ * append the whole of vec to itself. std::vector doesn't allow the range to
+ * be part of the vector, so its versions copy it out first.
+ */
+static void insert_self(std::vector<int> & vec, size_t pos, size_t first,
+        size_t last)
+{
+    std::vector<int> copy(vec.begin() + first, vec.begin() + last);
+    vec.insert(vec.begin() + pos, copy.begin(), copy.end());
+}
+
+static void insert_self(stll::vector<int> & vec, size_t pos, size_t first,
+        size_t last)
+{
+    vec.insert(vec.begin() + pos, vec.begin() + first, vec.begin() + last);
+}
+
+static void append_self(std::vector<int> & vec)
+{
+    std::vector<int> copy(vec);
+    vec.insert(vec.end(), copy.begin(), copy.end());
+}
+
+static void append_self(stll::vector<int> & vec)
+{
+    vec.append_range(vec);
+}
+
+/*
+ * Test the bulk operations by appending N integers in batches, filling a
+ * resized vector, inserting and erasing batches in the middle, and
+ * filtering out the odd numbers. A small vector then takes the insert paths
+ * the middle inserts don't reach. The contents of both vectors are copied
+ * to contents, so that the results for different vector types can be
+ * compared.
+ */
+template<typename T, size_t N> ResultList test_vector_bulk(
+        std::vector<int> & contents)
+{
+    ResultList resultlist;
+
+    T vec;
+    init_start_time();
+    for (size_t i = 0; i < N; i += BATCH_SIZE)
+    {
+        append_batch(vec, random_numbers + i, random_numbers + i + BATCH_SIZE);
+    }
+    resultlist.emplace_back("Append batch time", get_time());
+
+    T vec2;
+    init_start_time();
+    resize_for_fill(vec2, N);
+    for (size_t i = 0; i < N; i++)
+    {
+        vec2[i] = random_numbers[i];
+    }
+    resultlist.emplace_back("Resize and fill time", get_time());
+
+    init_start_time();
+    for (size_t i = 0; i < N_MIDDLE_BATCHES; i++)
+    {
+        vec.insert(vec.begin() + vec.size() / 2,
+                random_numbers + i * BATCH_SIZE, random_numbers + (i + 1) * BATCH_SIZE);
+    }
+    resultlist.emplace_back("Middle insert time", get_time());
+
+    init_start_time();
+    for (size_t i = 0; i < N_MIDDLE_BATCHES; i++)
+    {
+        auto middle = vec.begin() + vec.size() / 2;
+        vec.erase(middle, middle + BATCH_SIZE);
+    }
+    resultlist.emplace_back("Middle erase time", get_time());
+
+    init_start_time();
+    size_t removed = filter(vec, [](int x) { return (x & 1) != 0; });
+    resultlist.emplace_back("Filter time", get_time());
+
+    init_start_time();
+    vec.shrink_to_fit();
+    resultlist.emplace_back("Shrink to fit time", get_time());
+
+    // Once shrunk, the first insert has to reallocate. Erasing then leaves
+    // room for an insert which reaches past the end, and for one from the
+    // vector itself, before the next one from itself reallocates again.
+    T small;
+    append_batch(small, random_numbers, random_numbers + BATCH_SIZE);
+    small.shrink_to_fit();
+    small.insert(small.begin() + BATCH_SIZE / 2,
+            random_numbers, random_numbers + BATCH_SIZE);
+    small.erase(small.end() - BATCH_SIZE / 2, small.end());
+    small.insert(small.end() - BATCH_SIZE / 10,
+            random_numbers, random_numbers + BATCH_SIZE / 3);
+    insert_self(small, 10, BATCH_SIZE / 10, BATCH_SIZE / 5);
+    insert_self(small, 0, 0, BATCH_SIZE);
+    append_self(small);
+
+    contents.assign(vec.begin(), vec.end());
+    contents.push_back((int)removed);
+    contents.insert(contents.end(), small.begin(), small.end());
+    return resultlist;
+}
+
+/*
+ * Test sharing a vector of N integers by copying snapshots, then time
+ * readers taking snapshots while a writer publishes new versions.
+ */
+template<size_t N> ResultList test_shared_vector()
+{
+    ResultList resultlist;
+
+    stll::vector<int> vec;
+    for (size_t i = 0; i < N; i++)
+    {
+        vec.emplace_back(random_numbers[i]);
+    }
+    stll::shared_vector<int> shared(std::move(vec));
+
+    // Copy to a new vector
+    init_start_time();
+    stll::shared_vector<int> shared2(shared);
+    resultlist.emplace_back("Copy constructor time", get_time());
+
+    // The first write has to copy the contents away from shared
+    init_start_time();
+    shared2.set(0, 913);
+    resultlist.emplace_back("First write time", get_time());
+
+    // Subsequent writes don't
+    init_start_time();
+    for (size_t i = 0; i < N; i++)
+    {
+        shared2.set(i, shared[i] * 913);
+    }
+    resultlist.emplace_back("Multiply time", get_time());
+
+    // Readers snapshot a smaller vector as fast as they can while it is
+    // being republished
+    stll::vector<int> contended;
+    for (size_t i = 0; i < CONTENDED_VECTOR_SIZE; i++)
+    {
+        contended.emplace_back(random_numbers[i]);
+    }
+    stll::published_vector<int> published(stll::shared_vector<int>(std::move(contended)));
+
+    size_t n_readers = std::thread::hardware_concurrency();
+    if (n_readers < 2) n_readers = 2;
+    std::atomic<bool> done(false);
+    std::atomic<size_t> n_loads(0);
+    std::atomic<long long> checksum(0);
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < n_readers; r++)
+    {
+        readers.emplace_back([&]() {
+            size_t loads = 0;
+            long long sum = 0;
+            while (!done.load())
+            {
+                stll::shared_vector<int> snapshot = published.load();
+                sum += snapshot[loads % CONTENDED_VECTOR_SIZE];
+                loads++;
+            }
+            n_loads += loads;
+            checksum += sum;
+        });
+    }
+
+    init_start_time();
+    for (size_t i = 0; i < N_PUBLISHES; i++)
+    {
+        published.update([](stll::vector<int> & v) {
+            v[0] = v[0] + 1;
+        });
+    }
+    double update_time = get_time();
+
+    stll::shared_vector<int> next = published.load();
+    next.set(0, 0);
+    init_start_time();
+    for (size_t i = 0; i < N_PUBLISHES; i++)
+    {
+        published.publish(next);
+    }
+    double publish_time = get_time();
+
+    done = true;
+    for (auto & reader : readers)
+    {
+        reader.join();
+    }
+
+    resultlist.emplace_back("Writer update (copy and publish) time",
+            update_time / N_PUBLISHES);
+    resultlist.emplace_back("Writer publish time", publish_time / N_PUBLISHES);
+    resultlist.emplace_back("Reader snapshot time",
+            (update_time + publish_time) * n_readers / n_loads);
+
+    std::cout << checksum << std::endl;
+    return resultlist;
+}
+
+/*
+ * Several writers publish and update small versions whose elements all
+ * hold the same value, while readers take snapshots and check that each
+ * one is intact. A version freed under a reader shows up as a torn
+ * snapshot, or as a heap-use-after-free when built with
+ * -fsanitize=address.
+ */
+static void check_published_vector()
+{
+    stll::published_vector<int> published;
+    size_t n_threads = std::thread::hardware_concurrency();
+    if (n_threads < 4) n_threads = 4;
+    size_t n_writers = n_threads / 2;
+
+    std::atomic<bool> done(false);
+    std::atomic<size_t> n_torn(0);
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < n_threads - n_writers; r++)
+    {
+        readers.emplace_back([&]() {
+            while (!done.load())
+            {
+                stll::shared_vector<int> snapshot = published.load();
+                for (auto x : snapshot)
+                {
+                    if (x != snapshot[0])
+                    {
+                        n_torn++;
+                        break;
+                    }
+                }
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (size_t w = 0; w < n_writers; w++)
+    {
+        writers.emplace_back([&published, w]() {
+            for (size_t i = 0; i < N_STRESS_PUBLISHES; i++)
+            {
+                if (i % 2 == 0)
+                {
+                    stll::vector<int> vec;
+                    for (size_t j = 0; j < STRESS_VECTOR_SIZE; j++)
+                    {
+                        vec.emplace_back((int)(w * N_STRESS_PUBLISHES + i));
+                    }
+                    published.publish(stll::shared_vector<int>(std::move(vec)));
+                }
+                else
+                {
+                    published.update([](stll::vector<int> & v) {
+                        for (size_t j = 0; j < v.size(); j++)
+                        {
+                            v[j] = v[j] + 1;
+                        }
+                    });
+                }
+            }
+        });
+    }
+
+    for (auto & writer : writers)
+    {
+        writer.join();
+    }
+    done = true;
+    for (auto & reader : readers)
+    {
+        reader.join();
+    }
+
+    if (n_torn != 0)
+    {
+        std::cout << "ERROR: " << n_torn << " torn published vector snapshots"
+                  << std::endl;
+    }
+}
+
 
 int main()
 {
@@ -166,4 +499,34 @@ int main()
     std::cout << "Mini-SL vector results" << std::endl;
 
     std::cout << tsm;
+
+    std::vector<int> std_bulk;
+    ResultList tvb =
+        test_vector_bulk<std::vector<int>, MAX_VECTOR_SIZE>(std_bulk);
+    std::cout << "\n\n";
+    std::cout << "STD vector bulk results" << std::endl;
+
+    std::cout << tvb;
+
+    std::vector<int> sl_bulk;
+    ResultList tsb =
+        test_vector_bulk<stll::vector<int>, MAX_VECTOR_SIZE>(sl_bulk);
+    std::cout << "\n\n";
+    std::cout << "Mini-SL vector bulk results" << std::endl;
+
+    std::cout << tsb;
+
+    if (std_bulk != sl_bulk)
+    {
+        std::cout << "ERROR: bulk operations differ from std::vector"
+            << std::endl;
+    }
+
+    ResultList tsv = test_shared_vector<MAX_VECTOR_SIZE>();
+    std::cout << "\n\n";
+    std::cout << "Mini-SL shared vector results" << std::endl;
+
+    std::cout << tsv;
+
+    check_published_vector();
 }